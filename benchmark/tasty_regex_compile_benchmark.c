@@ -0,0 +1,146 @@
+/* external dependencies
+ * ────────────────────────────────────────────────────────────────────────── */
+#include "tasty_regex.h"	/* tasty_regex_compile|free */
+#include <stdio.h>		/* printf, sprintf */
+#include <time.h>		/* clock_gettime */
+
+
+/* helper macros
+ * ────────────────────────────────────────────────────────────────────────── */
+#define COUNT_WORDS_MIN		 64
+#define COUNT_WORDS_MAX		 16384
+#define COUNT_OPTIONALS_MIN	 4
+#define COUNT_OPTIONALS_MAX	 256
+#define COUNT_REPEATS		 5
+#define LENGTH_PATTERN_MAX	 (COUNT_WORDS_MAX * 8)
+
+
+/* helper functions
+ * ────────────────────────────────────────────────────────────────────────── */
+static double
+seconds_now(void)
+{
+	struct timespec time;
+
+	(void) clock_gettime(CLOCK_MONOTONIC,
+			     &time);
+
+	return ((double) time.tv_sec) + (((double) time.tv_nsec) * 1e-9);
+}
+
+/* best of COUNT_REPEATS compiles, in seconds (negative on failure) */
+static double
+time_compile(const char *const restrict pattern)
+{
+	struct TastyRegex regex;
+	double best;
+	double elapsed;
+	int repeat;
+
+	best = -1.0;
+
+	for (repeat = 0; repeat < COUNT_REPEATS; ++repeat) {
+		elapsed = seconds_now();
+
+		if (tasty_regex_compile(&regex,
+					pattern) != 0)
+			return -1.0;
+
+		elapsed = seconds_now() - elapsed;
+
+		tasty_regex_free(&regex);
+
+		if ((best < 0.0) || (elapsed < best))
+			best = elapsed;
+	}
+
+	return best;
+}
+
+/* "(waaa|wbaa|wcaa|…)": words sharing prefixes, as in a keyword list */
+static void
+put_dictionary(char *restrict pattern,
+	       const int count_words)
+{
+	int word;
+
+	*pattern = '(';
+	++pattern;
+
+	for (word = 0; word < count_words; ++word)
+		pattern += sprintf(pattern,
+				   "%sw%c%c%c",
+				   (word == 0) ? "" : "|",
+				   'a' + (word % 26),
+				   'a' + ((word / 26) % 26),
+				   'a' + ((word / 676) % 26));
+
+	pattern[0] = ')';
+	pattern[1] = '\0';
+}
+
+/* "a?b?c?…x|a?b?c?…y": alternatives sharing long optional prefixes */
+static void
+put_optionals(char *restrict pattern,
+	      const int count_optionals)
+{
+	int branch;
+	int optional;
+
+	for (branch = 0; branch < 2; ++branch) {
+		if (branch > 0) {
+			*pattern = '|';
+			++pattern;
+		}
+
+		for (optional = 0; optional < count_optionals; ++optional)
+			pattern += sprintf(pattern,
+					   "%c?",
+					   'a' + (optional % 23));
+
+		*pattern = "xy"[branch];
+		++pattern;
+	}
+
+	*pattern = '\0';
+}
+
+
+/* main
+ * ────────────────────────────────────────────────────────────────────────── */
+int
+main(void)
+{
+	static char pattern[LENGTH_PATTERN_MAX];
+	double seconds;
+	int count;
+
+	(void) printf("%-12s %10s %14s %16s\n",
+		      "pattern", "size", "compile (us)", "per item (ns)");
+
+	for (count = COUNT_WORDS_MIN; count <= COUNT_WORDS_MAX; count *= 2) {
+		put_dictionary(&pattern[0],
+			       count);
+
+		seconds = time_compile(&pattern[0]);
+
+		(void) printf("%-12s %10d %14.1f %16.1f\n",
+			      "dictionary", count, seconds * 1e6,
+			      (seconds * 1e9) / count);
+	}
+
+	for (count = COUNT_OPTIONALS_MIN;
+	     count <= COUNT_OPTIONALS_MAX;
+	     count *= 2) {
+		put_optionals(&pattern[0],
+			      count);
+
+		seconds = time_compile(&pattern[0]);
+
+		(void) printf("%-12s %10d %14.1f %16.1f\n",
+			      "optionals", count, seconds * 1e6,
+			      (seconds * 1e9) / count);
+	}
+
+	return 0;
+}
@@ -12,6 +12,7 @@
 #endif /* ifdef WIN32 */
 #include <unistd.h>		/* STDOUT/IN/ERR_FILENO, read, write, close */
 #include <errno.h>		/* errno */
+#include "tasty_regex_utils.h" /* LIKELY */
 
 /* helper macros
  * ────────────────────────────────────────────────────────────────────────── */
@@ -2,6 +2,7 @@
  * ────────────────────────────────────────────────────────────────────────── */
 #include "tasty_regex_compile.h"
 #include "tasty_regex_utils.h"
+#include <string.h>	/* memset, memcpy */
 
 
 /* helper macros
@@ -21,9 +22,63 @@
 
 #define IS_TASTY_CONTROL(STATUS) (STATUS < 0)
 
+/* state nodes lead with a 'skip' cell, followed by 1 cell per byte class */
+#define NODE_SPAN(REGEX) (((size_t) (REGEX)->span) + 1l)
+
+/* rows with at most this many explicit matches may be stored sparsely */
+#define TASTY_SPARSE_FANOUT_MAX		4
+
+/* state marks, used while flattening 'skip' routes and laying out rows */
+#define TASTY_MARK_FLATTENED		0x01
+#define TASTY_MARK_ON_STACK		0x02
+#define TASTY_MARK_ACCEPTING		0x04
+#define TASTY_MARK_REACHABLE		0x08
+
+/* merge memo, initial count of slots (power of 2), already-merged status */
+#define TASTY_MERGE_MEMO_INIT		64l
+#define TASTY_MERGE_SEEN		1
+
+/* tables beyond which only the literal prefix is extracted (and no row set
+ * is built) */
+#define TASTY_LITERAL_TABLE_LIMIT	(1l << 20)
+
+/* row leaders, used while minimizing */
+#define TASTY_ROW_UNSET			UINT32_MAX
+
+/* sets of bytes (or byte classes) are held as 256-bit masks */
+#define TASTY_BYTE_SET_WORDS		((UCHAR_MAX + 1) / 64)
+
+/* upper bound of repetition '{min,}' */
+#define TASTY_REPEAT_UNBOUNDED		UINT_MAX
+
+/* greatest code point, first and last surrogates (not encodable in UTF8) */
+#define TASTY_UTF8_POINT_MAX		0x10ffffu
+#define TASTY_UTF8_SURROGATE_FIRST	0xd800u
+#define TASTY_UTF8_SURROGATE_LAST	0xdfffu
+
+/* coverage of a range of code points by a character set */
+#define TASTY_COVER_NONE		0
+#define TASTY_COVER_PART		1
+#define TASTY_COVER_ALL			2
+
+/* steps of UTF8 automaton rows on a byte: none, into a shared tail of 1 to 3
+ * unconstrained continuation bytes, completing a character, or into a row of
+ * its own */
+#define TASTY_UTF8_STEP_DEAD		0
+#define TASTY_UTF8_STEP_CLOSE		4
+#define TASTY_UTF8_STEP_NODE		5
+
 
 /* typedefs, struct declarations
  * ────────────────────────────────────────────────────────────────────────── */
+/* DFA state node, used temporarily in compilation, spans a row of
+ * NODE_SPAN cells: cell 0 is reserved for 'skip' (no explicit match) and cell
+ * 'class + 1' jumps on an explicit match of byte class 'class' */
+union TastyState {
+	union TastyState *step; /* jump on match of byte class */
+	union TastyState *skip; /* no match option (first cell of row only) */
+};
+
 /* for tracking unset loose ends of DFA states */
 struct TastyPatch {
 	union TastyState *restrict *state;
@@ -41,6 +96,62 @@ struct TastyChunk {
 	struct TastyPatchList patches;
 };
 
+/* allocation sizes and byte classes, tallied in a pre-pass over pattern */
+struct TastyPatternSize {
+	size_t count_states;	   /* state rows */
+	size_t count_patches;	   /* patches independent of byte classes */
+	size_t count_wild_patches; /* wildcards (and brackets) needing a patch
+				    * per class */
+	bool anchor_end;	   /* ends with unescaped '$' */
+	bool over_budget;	   /* exceeds TASTY_STATE_CELL_BUDGET */
+	unsigned int count_labels; /* byte classes told apart so far */
+	unsigned int label_sizes[UCHAR_MAX + 1]; /* label → count of bytes */
+	unsigned char labels[UCHAR_MAX + 1];	  /* byte → class label */
+};
+
+/* rows reachable from initial row (node 0) as a graph with closing node
+ * 'count_nodes - 1', used while extracting literals and row sets */
+struct TastyRowGraph {
+	uint32_t count_nodes;
+	const uint32_t *rows;	/* node → row offset */
+	uint32_t *index_of;	/* row offset → node */
+	uint32_t *succ_start;	/* node → first of its edges in 'succ' */
+	uint32_t *succ;
+	uint32_t *pred_start;	/* node → first of its edges in 'pred' */
+	uint32_t *pred;
+	uint32_t *order;	/* node → postorder number */
+	uint32_t *idoms;	/* node → immediate dominator */
+	uint32_t *marks;	/* scratch */
+	uint32_t *in_degree;	/* scratch */
+	uint32_t *longest;	/* scratch */
+	uint32_t *queue;	/* scratch */
+};
+
+/* open-addressed set of state pairs visited while merging */
+struct TastyMergeMemo {
+	const union TastyState **pairs; /* 2 states per slot, NULL if empty */
+	size_t mask;			 /* count of slots - 1 */
+	size_t count;			 /* count of pairs recorded */
+};
+
+/* UTF8 characters matched by '.' ('members' NULL) or a bracket expression
+ * ('members' following '[' or '[^') under TASTY_COMPILE_UTF8 */
+struct TastyCharSet {
+	const unsigned char *members;
+	bool negated;
+	bool ignore_case;
+};
+
+/* row of UTF8 automaton: the root ('width' 0) steps on lead bytes, other rows
+ * on continuation bytes 'first' … 'last' of code points under 'base' with
+ * 'width' continuation bytes left */
+struct TastyUtf8Node {
+	unsigned int base;
+	unsigned int width;
+	unsigned int first;
+	unsigned int last;
+};
+
 struct TastyOrNode {
 	struct TastyChunk *chunk;
 	struct TastyOrNode *next;
@@ -70,551 +181,3973 @@ utf8_head_width(const unsigned char head)
 	return 0u; /* 11111xxx (not utf8) */
 }
 
-
-static inline void
-patch_states(struct TastyPatch *restrict patch,
-	     union TastyState *const restrict state)
+static inline bool
+utf8_tail_valid(const unsigned char *restrict tail,
+		unsigned int width)
 {
 	do {
-		*(patch->state) = state;
-		patch = patch->next;
-	} while (patch != NULL_POINTER);
-}
+		if ((*tail & 0xC0) != 0x80)
+			return false; /* not 10xxxxxx (includes '\0') */
 
-static inline void
-concat_patches(struct TastyPatchList *const restrict patches1,
-	       struct TastyPatchList *const restrict patches2)
-{
-	*(patches1->end_ptr) = patches2->head;
-	patches1->end_ptr    = patches2->end_ptr;
+		++tail;
+		--width;
+	} while (width > 0u);
+
+	return true;
 }
 
-static inline void
-merge_states(union TastyState *const restrict state1,
-	     union TastyState *const restrict state2)
+/* decode multibyte 'sequence' into 'point', false if malformed, overlong, a
+ * surrogate or beyond TASTY_UTF8_POINT_MAX */
+static inline bool
+utf8_decode_point(unsigned int *const restrict point,
+		  const unsigned char *restrict *const restrict sequence_ptr)
 {
-	union TastyState *restrict *restrict state1_from;
-	union TastyState *restrict *restrict state2_from;
-
-	state1_from = &state1->skip;
+	static const unsigned int least_point[5] = {
+		[2] = 0x80u,
+		[3] = 0x800u,
+		[4] = 0x10000u
+	};
 
-	/* flatten skip route in state1 */
-	if (*state1_from != NULL_POINTER)
-		merge_states(*state1_from,
-			     state2);
+	const unsigned char *const restrict sequence = *sequence_ptr;
+	unsigned int value;
+	unsigned int i;
 
-	state2_from = &state2->skip;
+	const unsigned int width = utf8_head_width(*sequence);
 
-	/* flatten skip route in state2 */
-	if (*state2_from != NULL_POINTER)
-		merge_states(state1,
-			     *state2_from);
+	if (   (width < 2u)
+	    || !utf8_tail_valid(sequence + 1l,
+				width - 1u))
+		return false;
 
-	++state1_from;
-	union TastyState *restrict *const restrict state1_until
-	= state1_from + UCHAR_MAX;
+	value = *sequence & (0x7fu >> width);
 
-	++state2_from;
+	for (i = 1u; i < width; ++i)
+		value = (value << 6) | (sequence[i] & 0x3fu);
 
-	while (1) {
-		/* no conflict, merge state2's branch into state1 */
-		if (*state1_from == NULL_POINTER) {
-			*state1_from = *state2_from;
+	if (   (value < least_point[width])
+	    || (value > TASTY_UTF8_POINT_MAX)
+	    || (   (value >= TASTY_UTF8_SURROGATE_FIRST)
+		&& (value <= TASTY_UTF8_SURROGATE_LAST)))
+		return false;
 
-		/* fork on same match (NFA), need to flatten branch */
-		} else if (*state2_from != NULL_POINTER) {
-			merge_states(*state1_from,
-				     *state2_from);
-		}
+	*point	      = value;
+	*sequence_ptr = sequence + width;
+	return true;
+}
 
-		++state1_from;
-		if (state1_from == state1_until)
-			return;
 
-		++state2_from;
-	}
+static inline bool
+byte_set_has(const uint64_t *const restrict set,
+	     const unsigned int byte)
+{
+	return (set[byte >> 6] >> (byte & 63u)) & 1u;
 }
 
 static inline void
-copy_steps(union TastyState *const restrict state1,
-	   union TastyState *const restrict state2)
+byte_set_add(uint64_t *const restrict set,
+	     const unsigned int byte)
 {
-	union TastyState *restrict *restrict state1_from;
-	union TastyState *restrict *restrict state2_from;
+	set[byte >> 6] |= ((uint64_t) 1u) << (byte & 63u);
+}
 
-	state1_from = &state1->step[1];
-	state2_from = &state2->step[1];
 
-	union TastyState *restrict *const restrict state1_until
-	= state1_from + UCHAR_MAX;
+/* other case of ASCII letter 'byte', or 'byte' itself if not a letter */
+static inline unsigned int
+ascii_other_case(const unsigned int byte)
+{
+	return (((byte | 0x20u) >= 'a') && ((byte | 0x20u) <= 'z'))
+	     ? (byte ^ 0x20u)
+	     : byte;
+}
 
-	while (1) {
-		*state1_from = *state2_from;
+/* other case of two-byte code point 'point' under simple one-to-one case
+ * folding of Latin-1, Latin Extended-A, Greek, Cyrillic and Armenian
+ * letters, or 'point' itself if none */
+static inline unsigned int
+utf8_other_case(const unsigned int point)
+{
+	if (point < 0x00c0u)
+		return point;
 
-		++state1_from;
-		if (state1_from == state1_until)
-			return;
+	if (point <= 0x00feu) /* À-Þ ↔ à-þ, save × ß ÷ */
+		return ((point == 0x00d7u) || (point == 0x00dfu)
+					   || (point == 0x00f7u))
+		     ? point
+		     : (point ^ 0x20u);
 
-		++state2_from;
-	}
-}
+	if (point == 0x00ffu) /* ÿ ↔ Ÿ */
+		return 0x0178u;
 
+	if (point == 0x0178u)
+		return 0x00ffu;
 
-static inline void
-merge_chunks(struct TastyChunk *const restrict chunk1,
-	     struct TastyChunk *const restrict chunk2)
-{
-	merge_states(chunk1->start,
-		     chunk2->start);
+	if (point < 0x0180u) { /* Latin Extended-A pairs */
+		if (   (point == 0x0130u) || (point == 0x0131u)
+		    || (point == 0x0138u) || (point == 0x0149u)
+		    || (point == 0x017fu))
+			return point;
 
-	concat_patches(&chunk1->patches,
-		       &chunk2->patches);
-}
+		/* pairs begin on an odd point in 'Ĺ'-'ň' and 'Ź'-'ž' */
+		if (   ((point >= 0x0139u) && (point <= 0x0148u))
+		    || (point >= 0x0179u))
+			return ((point - 1u) ^ 1u) + 1u;
 
-static inline void
-concat_chunks(struct TastyChunk *const restrict chunk1,
-	      struct TastyChunk *const restrict chunk2)
-{
-	patch_states(chunk1->patches.head,
-		     chunk2->start);
+		return point ^ 1u;
+	}
 
-	chunk1->patches = chunk2->patches;
+	if (point < 0x0386u)
+		return point;
+
+	if (point < 0x03d0u) { /* Greek */
+		if (point == 0x0386u)
+			return 0x03acu;
+		if (point == 0x03acu)
+			return 0x0386u;
+		if ((point >= 0x0388u) && (point <= 0x038au))
+			return point + 0x25u;
+		if ((point >= 0x03adu) && (point <= 0x03afu))
+			return point - 0x25u;
+		if (point == 0x038cu)
+			return 0x03ccu;
+		if (point == 0x03ccu)
+			return 0x038cu;
+		if ((point == 0x038eu) || (point == 0x038fu))
+			return point + 0x3fu;
+		if ((point == 0x03cdu) || (point == 0x03ceu))
+			return point - 0x3fu;
+		if ((point >= 0x0391u) && (point <= 0x03abu) && (point != 0x03a2u))
+			return point + 0x20u;
+		if ((point >= 0x03b1u) && (point <= 0x03cbu) && (point != 0x03c2u))
+			return point - 0x20u;
+		return point;
+	}
+
+	if (point < 0x0400u)
+		return point;
+
+	if (point < 0x0530u) { /* Cyrillic */
+		if (point < 0x0410u)
+			return point + 0x50u;
+		if (point < 0x0430u)
+			return point + 0x20u;
+		if (point < 0x0450u)
+			return point - 0x20u;
+		if (point < 0x0460u)
+			return point - 0x50u;
+		if ((point >= 0x04c1u) && (point <= 0x04ceu))
+			return ((point - 1u) ^ 1u) + 1u;
+		if (   (point <= 0x0481u)
+		    || ((point >= 0x048au) && (point <= 0x04bfu))
+		    || (point >= 0x04d0u))
+			return point ^ 1u;
+		return point;
+	}
+
+	/* Armenian */
+	if ((point >= 0x0531u) && (point <= 0x0556u))
+		return point + 0x30u;
+	if ((point >= 0x0561u) && (point <= 0x0586u))
+		return point - 0x30u;
+
+	return point;
 }
 
-static inline void
-sub_chunk_zero_or_more(struct TastyChunk *const restrict chunk)
+/* write the other case of the two-byte 'sequence' into 'fold', if any */
+static inline bool
+utf8_fold_pair(const unsigned char *const restrict sequence,
+	       unsigned char *const restrict fold)
 {
-	struct TastyPatchList *const restrict chunk_patches = &chunk->patches;
+	const unsigned int point = ((sequence[0] & 0x1fu) << 6)
+				 |  (sequence[1] & 0x3fu);
 
-	struct TastyPatch *const restrict chunk_patches_head
-	= chunk_patches->head;
+	const unsigned int other = utf8_other_case(point);
 
-	patch_states(chunk_patches_head,
-		     chunk->start);
+	if (other == point)
+		return false;
 
-	chunk_patches_head->state = &chunk->start->skip;
-	chunk_patches_head->next  = NULL_POINTER;
-	chunk_patches->end_ptr	  = &chunk_patches_head->next;
+	fold[0] = (unsigned char) (0xc0u | (other >> 6));
+	fold[1] = (unsigned char) (0x80u | (other & 0x3fu));
+	return true;
 }
 
-static inline void
-sub_chunk_one_or_more(struct TastyChunk *const restrict chunk,
-		      union TastyState *restrict *const restrict state_alloc)
+/* fetch a single member of a bracket expression (ASCII, or any character
+ * under TASTY_COMPILE_UTF8) */
+static inline bool
+bracket_member(unsigned int *const restrict member,
+	       const unsigned char *restrict *const restrict pattern_ptr,
+	       const bool utf8)
 {
-	/* pop state node */
-	union TastyState *const restrict state = *state_alloc;
-	++(*state_alloc);
+	static const bool valid_escape_map[UCHAR_MAX + 1] = {
+		['\\'] = true,
+		[']']  = true,
+		['[']  = true,
+		['-']  = true,
+		['^']  = true
+	};
 
-	/* append state node that will loop on a match or skip */
-	copy_steps(state,
-		   chunk->start);
+	const unsigned char *restrict pattern;
+	unsigned int token;
 
-	struct TastyPatchList *const restrict chunk_patches = &chunk->patches;
-	struct TastyPatch *const restrict chunk_patches_head
-	= chunk_patches->head;
+	pattern = *pattern_ptr;
+	token   = *pattern;
 
-	patch_states(chunk_patches->head,
-		     state);
+	if (token == '\\') {
+		++pattern;
+		token = *pattern;
 
-	chunk_patches_head->state = &state->skip;
-	chunk_patches_head->next  = NULL_POINTER;
-	chunk_patches->end_ptr	  = &chunk_patches_head->next;
-}
+		if (!valid_escape_map[token])
+			return false;
 
-static inline void
-sub_chunk_zero_or_one(struct TastyChunk *const restrict chunk,
-		      struct TastyPatch *restrict *const restrict patch_alloc)
-{
-	/* pop patch node */
-	struct TastyPatch *const restrict patch = *patch_alloc;
-	++(*patch_alloc);
+	} else if (token > 0x7fu) {
+		return utf8 && utf8_decode_point(member,
+						 pattern_ptr);
 
-	/* record skip over entire chunk */
-	patch->state = &chunk->start->skip;
+	} else if (token == '\0') {
+		return false; /* unterminated */
+	}
 
-	/* push patch into head of patch_list */
-	patch->next  = chunk->patches.head;
-	chunk->patches.head = patch;
+	*member	     = token;
+	*pattern_ptr = pattern + 1l;
+	return true;
 }
 
-static inline void
-close_sub_chunk(struct TastyChunk *const restrict chunk,
-		union TastyState *restrict *const restrict state_alloc,
-		struct TastyPatch *restrict *const restrict patch_alloc,
-		const unsigned char *restrict *const restrict pattern_ptr)
+/* fetch next member or range of members 'first' … 'last' of bracket
+ * expression 'members', false if malformed or at closing ']' */
+static inline bool
+bracket_range(unsigned int *const restrict first,
+	      unsigned int *const restrict last,
+	      const unsigned char *restrict *const restrict pattern_ptr,
+	      const unsigned char *const restrict members,
+	      const bool utf8)
 {
-	switch (**pattern_ptr) {
-	case '*':
-		++(*pattern_ptr);
-		sub_chunk_zero_or_more(chunk);
-		return;
+	const unsigned char *restrict pattern = *pattern_ptr;
+
+	/* leading ']' is a member */
+	if ((pattern == members) && (*pattern == ']')) {
+		*first	     = ']';
+		*last	     = ']';
+		*pattern_ptr = pattern + 1l;
+		return true;
+	}
 
-	case '+':
-		++(*pattern_ptr);
-		sub_chunk_one_or_more(chunk,
-				      state_alloc);
-		return;
+	if (   (*pattern == ']')
+	    || !bracket_member(first,
+			       &pattern,
+			       utf8))
+		return false;
 
-	case '?':
-		++(*pattern_ptr);
-		sub_chunk_zero_or_one(chunk,
-				      patch_alloc);
-		return;
+	*last = *first;
 
-	default: /* no nothing */
-		return;
+	/* '-' is a member if last in expression, else forms range */
+	if ((pattern[0] == '-') && (pattern[1] != ']')) {
+		++pattern;
+
+		if (   !bracket_member(last,
+				       &pattern,
+				       utf8)
+		    || (*last < *first))
+			return false;
 	}
-}
 
+	*pattern_ptr = pattern;
+	return true;
+}
 
-static inline void
-push_wild_patches(struct TastyPatch *restrict *const restrict patch_head,
-		  struct TastyPatch *restrict *const restrict patch_alloc,
-		  union TastyState *const restrict state)
+/* parse bracket expression following '[' into set of ASCII 'members'
+ * (matched unless 'negated'), returning end of expression (past closing ']')
+ * or NULL if malformed (a leading ']' is a member, so no expression is
+ * empty).  Under TASTY_COMPILE_UTF8 ('utf8'), members may be any character
+ * and are left to a TastyCharSet instead. */
+static inline const unsigned char *
+parse_bracket(uint64_t *const restrict members,
+	      bool *const restrict negated,
+	      const unsigned char *restrict pattern,
+	      const bool utf8)
 {
-	struct TastyPatch *restrict patch;
-	struct TastyPatch *restrict next_patch;
-	union TastyState *restrict *restrict state_from;
-
-	/* init list traversal vars */
-	next_patch = *patch_head;
-	patch	   = *patch_alloc;
+	unsigned int first;
+	unsigned int last;
 
-	/* starting from first non-NULL match */
-	state_from = &state->step[1];
+	(void) memset(members,
+		      0,
+		      sizeof(uint64_t) * TASTY_BYTE_SET_WORDS);
 
-	union TastyState *const restrict *restrict state_until
-	= state_from + UCHAR_MAX;
+	*negated = (*pattern == '^');
 
-	do {
-		patch->state = state_from;
-		patch->next  = next_patch;
+	pattern += *negated;
 
-		next_patch = patch;
-		++patch;
+	const unsigned char *const restrict members_start = pattern;
 
-		++state_from;
-	} while (state_from < state_until);
+	while (bracket_range(&first,
+			     &last,
+			     &pattern,
+			     members_start,
+			     utf8))
+		if (!utf8)
+			for (; first <= last; ++first)
+				byte_set_add(members,
+					     first);
 
-	/* update head of list, alloc */
-	*patch_head  = next_patch;
-	*patch_alloc = patch;
+	return (*pattern == ']')
+	     ? (pattern + 1l)
+	     : NULL_POINTER;
 }
 
-static inline void
-join_wild_state(union TastyState *const restrict wild_state,
-		union TastyState *const restrict next_state)
+/* 'point' is listed in bracket expression of 'set' (never, for '.') */
+static inline bool
+char_set_lists(const struct TastyCharSet *const restrict set,
+	       const unsigned int point)
 {
-	union TastyState *restrict *restrict state_from;
+	const unsigned char *restrict pattern;
+	unsigned int first;
+	unsigned int last;
 
-	/* starting from first non-NULL match */
-	state_from = &wild_state->step[1];
+	pattern = set->members;
 
-	union TastyState *const restrict *restrict state_until
-	= state_from + UCHAR_MAX;
+	if (pattern == NULL_POINTER)
+		return false;
 
-	do {
-		*state_from = next_state;
-		++state_from;
-	} while (state_from < state_until);
-}
+	while (bracket_range(&first,
+			     &last,
+			     &pattern,
+			     set->members,
+			     true))
+		if ((point >= first) && (point <= last))
+			return true;
 
+	return false;
+}
 
-/* fundamental state elements
- * ────────────────────────────────────────────────────────────────────────── */
-static inline void
-match_one(union TastyState *const restrict state,
-	  struct TastyPatch *restrict *const restrict patch_alloc,
-	  struct TastyPatch *restrict *const restrict patch_head,
-	  const unsigned char token)
+/* 'point' is matched by 'set' */
+static inline bool
+char_set_has(const struct TastyCharSet *const restrict set,
+	     const unsigned int point)
 {
-	/* pop patch node */
-	struct TastyPatch *const restrict patch = *patch_alloc;
-	++(*patch_alloc);
-
-	/* record pointer needing to be set */
-	patch->state = &state->step[token];
+	bool has = char_set_lists(set,
+				  point);
+
+	if (!has && set->ignore_case) {
+		const unsigned int other = (point < 0x80u)
+					 ? ascii_other_case(point)
+					 : ((point < 0x800u)
+					    ? utf8_other_case(point)
+					    : point);
+
+		has = (other != point) && char_set_lists(set,
+							 other);
+	}
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+	return has != set->negated;
 }
 
-static inline void
-wild_one(union TastyState *const restrict state,
-	 struct TastyPatch *restrict *const restrict patch_alloc,
-	 struct TastyPatch *restrict *const restrict patch_head)
+/* coverage of code points 'from' … 'until' by 'set' */
+static inline int
+char_set_cover(const struct TastyCharSet *const restrict set,
+	       const unsigned int from,
+	       const unsigned int until)
 {
-	/* push a patch node for every UCHAR */
-	push_wild_patches(patch_head,
-			  patch_alloc,
-			  state);
+	const unsigned char *restrict pattern;
+	unsigned int first;
+	unsigned int last;
+	unsigned int point;
+	unsigned int count;
+	bool advanced;
+	bool none;
+
+	/* case folds (of two-byte letters at most) are checked point by
+	 * point */
+	if (set->ignore_case && (from < 0x800u)) {
+		count = 0u;
+
+		for (point = from; point <= until; ++point)
+			count += char_set_has(set,
+					      point);
+
+		return (count == 0u)
+		     ? TASTY_COVER_NONE
+		     : ((count == (until - from + 1u))
+			? TASTY_COVER_ALL
+			: TASTY_COVER_PART);
+	}
+
+	if (set->members == NULL_POINTER)
+		return set->negated
+		     ? TASTY_COVER_ALL
+		     : TASTY_COVER_NONE;
+
+	/* listed if no range overlaps, unlisted if ranges chain past 'until' */
+	none	= true;
+	pattern = set->members;
+
+	while (bracket_range(&first,
+			     &last,
+			     &pattern,
+			     set->members,
+			     true))
+		if ((first <= until) && (last >= from))
+			none = false;
+
+	point = from;
+
+	do {
+		advanced = false;
+		pattern  = set->members;
+
+		while (bracket_range(&first,
+				     &last,
+				     &pattern,
+				     set->members,
+				     true))
+			if ((first <= point) && (last >= point)) {
+				point	 = last + 1u;
+				advanced = true;
+			}
+	} while (advanced && (point <= until));
+
+	if (none)
+		return set->negated
+		     ? TASTY_COVER_ALL
+		     : TASTY_COVER_NONE;
+
+	if (point > until)
+		return set->negated
+		     ? TASTY_COVER_NONE
+		     : TASTY_COVER_ALL;
+
+	return TASTY_COVER_PART;
 }
 
+/* row stepped into from UTF8 automaton row 'node' on 'byte' */
 static inline void
-match_wide_one(union TastyState *const restrict state_last,
-	       struct TastyPatch *restrict *const restrict patch_alloc,
-	       struct TastyPatch *restrict *const restrict patch_head,
-	       const unsigned char token_last)
+utf8_child_node(struct TastyUtf8Node *const restrict child,
+		const struct TastyUtf8Node *const restrict node,
+		const unsigned int byte)
 {
-	/* pop patch node */
-	struct TastyPatch *const restrict patch = *patch_alloc;
-	++(*patch_alloc);
+	child->first = 0x80u;
+	child->last  = 0xbfu;
 
-	/* record pointer needing to be set */
-	patch->state = &state_last->step[token_last];
+	if (node->width > 0u) {
+		child->width = node->width - 1u;
+		child->base  = node->base
+			     | ((byte & 0x3fu) << (6u * child->width));
+		return;
+	}
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+	/* lead byte, excluding overlong forms, surrogates and points beyond
+	 * TASTY_UTF8_POINT_MAX by its second byte */
+	if (byte <= 0xdfu) {
+		child->width = 1u;
+		child->base  = (byte & 0x1fu) << 6;
+
+	} else if (byte <= 0xefu) {
+		child->width = 2u;
+		child->base  = (byte & 0x0fu) << 12;
+
+		if (byte == 0xe0u)
+			child->first = 0xa0u;
+		else if (byte == 0xedu)
+			child->last  = 0x9fu;
+
+	} else {
+		child->width = 3u;
+		child->base  = (byte & 0x07u) << 18;
+
+		if (byte == 0xf0u)
+			child->first = 0x90u;
+		else if (byte == 0xf4u)
+			child->last  = 0x8fu;
+	}
 }
 
-
+/* step of UTF8 automaton row 'node' of 'set' on every byte */
 static inline void
-match_zero_or_one(union TastyState *const restrict state,
-		  struct TastyPatch *restrict *const restrict patch_alloc,
-		  struct TastyPatch *restrict *const restrict patch_head,
-		  const unsigned char token)
+utf8_node_steps(unsigned char *const restrict steps,
+		const struct TastyCharSet *const restrict set,
+		const struct TastyUtf8Node *const restrict node)
 {
-	struct TastyPatch *restrict patch;
+	struct TastyUtf8Node child;
+	unsigned int byte;
+	unsigned int first;
+	unsigned int last;
+	int cover;
+
+	(void) memset(steps,
+		      TASTY_UTF8_STEP_DEAD,
+		      UCHAR_MAX + 1);
+
+	if (node->width == 0u) {
+		for (byte = 0u; byte < 0x80u; ++byte)
+			if (char_set_has(set,
+					 byte))
+				steps[byte] = TASTY_UTF8_STEP_CLOSE;
+
+		first = 0xc2u;
+		last  = 0xf4u;
+
+	} else {
+		first = node->first;
+		last  = node->last;
+	}
 
-	/* pop patch node */
-	 patch = *patch_alloc;
-	*patch_alloc += 2l; /* account for second patch */
+	for (byte = first; byte <= last; ++byte) {
+		utf8_child_node(&child,
+				node,
+				byte);
 
-	/* record skip pointer needing to be set */
-	patch->state = &state->skip;
+		if (child.width == 0u) {
+			if (char_set_has(set,
+					 child.base))
+				steps[byte] = TASTY_UTF8_STEP_CLOSE;
+			continue;
+		}
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+		const unsigned int shift = 6u * (child.width - 1u);
 
-	/* pop patch node */
-	++patch;
+		cover = char_set_cover(set,
+				       child.base
+				       + ((child.first & 0x3fu) << shift),
+				       child.base
+				       + (((child.last & 0x3fu) + 1u) << shift)
+				       - 1u);
 
-	/* record match pointer needing to be set */
-	patch->state = &state->step[token];
+		if (cover == TASTY_COVER_NONE)
+			continue;
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+		/* a tail steps on any continuation byte */
+		steps[byte] = (   (cover == TASTY_COVER_ALL)
+			       && (child.first == 0x80u)
+			       && (child.last  == 0xbfu))
+			    ? (unsigned char) child.width
+			    : TASTY_UTF8_STEP_NODE;
+	}
 }
 
-static inline void
-wild_zero_or_one(union TastyState *const restrict state,
-		 struct TastyPatch *restrict *const restrict patch_alloc,
-		 struct TastyPatch *restrict *const restrict patch_head)
+/* read decimal count of repetition, saturating past TASTY_REPEAT_MAX */
+static inline bool
+repeat_count(unsigned int *const restrict count,
+	     const unsigned char *restrict *const restrict pattern_ptr)
 {
-	struct TastyPatch *restrict patch;
+	const unsigned char *restrict pattern;
+	unsigned int value;
 
-	/* pop patch node */
-	 patch = *patch_alloc;
-	++(*patch_alloc);
+	pattern = *pattern_ptr;
 
-	/* record skip pointer needing to be set */
-	patch->state = &state->skip;
+	if ((*pattern < '0') || (*pattern > '9'))
+		return false;
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+	value = 0u;
 
-	/* push a patch node for every UCHAR */
-	push_wild_patches(patch_head,
-			  patch_alloc,
-			  state);
+	do {
+		if (value <= TASTY_REPEAT_MAX)
+			value = (value * 10u) + (*pattern - '0');
+
+		++pattern;
+	} while ((*pattern >= '0') && (*pattern <= '9'));
+
+	*count	     = value;
+	*pattern_ptr = pattern;
+	return true;
+}
+
+/* parse bounds of repetition '{min,max}', '{n}', '{min,}' or '{,max}' at
+ * 'pattern', returning end of repetition (past '}') or NULL if 'pattern'
+ * opens none (and '{' matches itself) */
+static inline const unsigned char *
+parse_repetition(unsigned int *const restrict min,
+		 unsigned int *const restrict max,
+		 const unsigned char *restrict pattern)
+{
+	++pattern; /* skip '{' */
+
+	const bool has_min = repeat_count(min,
+					  &pattern);
+
+	if (*pattern == '}') {
+		*max = *min;
+		return has_min ? (pattern + 1l) : NULL_POINTER;
+	}
+
+	if (*pattern != ',')
+		return NULL_POINTER;
+
+	++pattern;
+
+	const bool has_max = repeat_count(max,
+					  &pattern);
+
+	if ((*pattern != '}') || !(has_min || has_max))
+		return NULL_POINTER;
+
+	if (!has_min)
+		*min = 0u;
+
+	if (!has_max)
+		*max = TASTY_REPEAT_UNBOUNDED;
+
+	return pattern + 1l;
+}
+
+static inline bool
+repetition_valid(const unsigned int min,
+		 const unsigned int max)
+{
+	return (min <= TASTY_REPEAT_MAX)
+	    && (max != 0u)
+	    && (   (max == TASTY_REPEAT_UNBOUNDED)
+		|| ((max <= TASTY_REPEAT_MAX) && (min <= max)));
+}
+
+/* operand parsed from 'operand' to 'end' may be repeated (it has no
+ * operator, whereas a trailing '*', '+' or '?' is one unless escaped) */
+static inline bool
+operand_repeatable(const unsigned char *const restrict operand,
+		   const unsigned char *const restrict end)
+{
+	if ((end == operand) || (*operand == '|'))
+		return false;
+
+	switch (end[-1]) {
+	case '*':
+	case '+':
+	case '?':
+		return (operand[0] == '\\') && ((end - operand) == 2l);
+
+	default:
+		return true;
+	}
 }
 
+
 static inline void
-match_wide_zero_or_one(union TastyState *const restrict state_first,
-		       union TastyState *const restrict state_last,
-		       struct TastyPatch *restrict *const restrict patch_alloc,
-		       struct TastyPatch *restrict *const restrict patch_head,
-		       const unsigned char token_last)
+patch_states(struct TastyPatch *restrict patch,
+	     union TastyState *const restrict state)
 {
-	struct TastyPatch *restrict patch;
+	do {
+		*(patch->state) = state;
+		patch = patch->next;
+	} while (patch != NULL_POINTER);
+}
 
-	/* pop patch node */
-	 patch = *patch_alloc;
-	*patch_alloc += 2l; /* account for second patch */
+static inline void
+concat_patches(struct TastyPatchList *const restrict patches1,
+	       struct TastyPatchList *const restrict patches2)
+{
+	*(patches1->end_ptr) = patches2->head;
+	patches1->end_ptr    = patches2->end_ptr;
+}
 
-	/* record skip pointer needing to be set */
-	patch->state = &state_first->skip;
+static inline size_t
+merge_memo_slot(const struct TastyMergeMemo *const restrict memo,
+		const union TastyState *const state1,
+		const union TastyState *const state2)
+{
+	size_t hash;
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+	hash  = ((size_t) (uintptr_t) state1) * 0x9E3779B1u;
+	hash ^= ((size_t) (uintptr_t) state2) * 0x85EBCA77u;
+	hash ^= hash >> 16;
 
-	/* pop patch node */
-	++patch;
+	return hash & memo->mask;
+}
 
-	/* record match pointer needing to be set */
-	patch->state = &state_last->step[token_last];
+static inline int
+merge_memo_grow(struct TastyMergeMemo *const restrict memo)
+{
+	const union TastyState **restrict pair;
+	size_t slot;
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+	const union TastyState **const restrict old_pairs = memo->pairs;
+	const size_t old_count_slots			   = memo->mask + 1l;
+	const size_t count_slots			   = old_count_slots * 2l;
+
+	const union TastyState **const restrict pairs
+	= calloc(count_slots * 2l,
+		 sizeof(const union TastyState *));
+
+	if (UNLIKELY(pairs == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	memo->pairs = pairs;
+	memo->mask  = count_slots - 1l;
+
+	/* rehash occupied slots */
+	for (pair = old_pairs;
+	     pair < (old_pairs + (old_count_slots * 2l));
+	     pair += 2l) {
+		if (pair[0] == NULL_POINTER)
+			continue;
+
+		slot = merge_memo_slot(memo,
+				       pair[0],
+				       pair[1]);
+
+		while (pairs[slot * 2l] != NULL_POINTER)
+			slot = (slot + 1l) & memo->mask;
+
+		pairs[slot * 2l]      = pair[0];
+		pairs[(slot * 2l) + 1l] = pair[1];
+	}
+
+	free(old_pairs);
+
+	return 0;
+}
+
+/* record pair (state1, state2), TASTY_MERGE_SEEN if already recorded */
+static inline int
+merge_memo_insert(struct TastyMergeMemo *const restrict memo,
+		  const union TastyState *const state1,
+		  const union TastyState *const state2)
+{
+	size_t slot;
+	int status;
+
+	const union TastyState **restrict pair;
+
+	slot = merge_memo_slot(memo,
+			       state1,
+			       state2);
+
+	while (1) {
+		pair = &memo->pairs[slot * 2l];
+
+		if (pair[0] == NULL_POINTER)
+			break;
+
+		if ((pair[0] == state1) && (pair[1] == state2))
+			return TASTY_MERGE_SEEN;
+
+		slot = (slot + 1l) & memo->mask;
+	}
+
+	/* keep load factor at most 1/2 */
+	if ((memo->count * 2l) >= memo->mask) {
+		status = merge_memo_grow(memo);
+
+		if (status != 0)
+			return status;
+
+		return merge_memo_insert(memo,
+					 state1,
+					 state2);
+	}
+
+	pair[0] = state1;
+	pair[1] = state2;
+	++(memo->count);
+
+	return 0;
+}
+
+/* merge state2's branches into state1, recording each pair of states merged
+ * in 'memo' so that shared (or cyclic) branches are merged only once */
+static inline int
+merge_states(struct TastyMergeMemo *const restrict memo,
+	     union TastyState *const restrict state1,
+	     union TastyState *const restrict state2,
+	     const size_t span)
+{
+	union TastyState *restrict state1_from;
+	union TastyState *restrict state2_from;
+	int status;
+
+	status = merge_memo_insert(memo,
+				   state1,
+				   state2);
+	if (status != 0)
+		return (status == TASTY_MERGE_SEEN) ? 0 : status;
+
+	state1_from = state1;
+
+	/* flatten skip route in state1 */
+	if (state1_from->skip != NULL_POINTER) {
+		status = merge_states(memo,
+				      state1_from->skip,
+				      state2,
+				      span);
+		if (status != 0)
+			return status;
+	}
+
+	state2_from = state2;
+
+	/* flatten skip route in state2 */
+	if (state2_from->skip != NULL_POINTER) {
+		status = merge_states(memo,
+				      state1,
+				      state2_from->skip,
+				      span);
+		if (status != 0)
+			return status;
+	}
+
+	++state1_from;
+	union TastyState *const restrict state1_until = state1 + span;
+
+	++state2_from;
+
+	while (1) {
+		/* no conflict, merge state2's branch into state1 */
+		if (state1_from->step == NULL_POINTER) {
+			state1_from->step = state2_from->step;
+
+		/* fork on same match (NFA), need to flatten branch */
+		} else if (state2_from->step != NULL_POINTER) {
+			status = merge_states(memo,
+					      state1_from->step,
+					      state2_from->step,
+					      span);
+			if (status != 0)
+				return status;
+		}
+
+		++state1_from;
+		if (state1_from == state1_until)
+			return 0;
+
+		++state2_from;
+	}
+}
+
+static inline void
+copy_steps(union TastyState *const restrict state1,
+	   union TastyState *const restrict state2,
+	   const size_t span)
+{
+	union TastyState *restrict state1_from;
+	union TastyState *restrict state2_from;
+
+	state1_from = state1 + 1l;
+	state2_from = state2 + 1l;
+
+	union TastyState *const restrict state1_until = state1 + span;
+
+	while (1) {
+		state1_from->step = state2_from->step;
+
+		++state1_from;
+		if (state1_from == state1_until)
+			return;
+
+		++state2_from;
+	}
 }
 
 
+static inline int
+merge_chunks(struct TastyChunk *const restrict chunk1,
+	     struct TastyChunk *const restrict chunk2,
+	     const size_t span)
+{
+	struct TastyMergeMemo memo;
+
+	memo.pairs = calloc(TASTY_MERGE_MEMO_INIT * 2l,
+			    sizeof(const union TastyState *));
+
+	if (UNLIKELY(memo.pairs == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	memo.mask  = TASTY_MERGE_MEMO_INIT - 1l;
+	memo.count = 0l;
+
+	const int status = merge_states(&memo,
+					chunk1->start,
+					chunk2->start,
+					span);
+
+	free(memo.pairs);
+
+	concat_patches(&chunk1->patches,
+		       &chunk2->patches);
+
+	return status;
+}
+
 static inline void
-match_zero_or_more(union TastyState *const restrict state,
-		   struct TastyPatch *restrict *const restrict patch_alloc,
-		   struct TastyPatch *restrict *const restrict patch_head,
-		   const unsigned char token)
+concat_chunks(struct TastyChunk *const restrict chunk1,
+	      struct TastyChunk *const restrict chunk2)
 {
-	/* pop patch node */
-	struct TastyPatch *const restrict patch = *patch_alloc;
-	++(*patch_alloc);
+	patch_states(chunk1->patches.head,
+		     chunk2->start);
 
-	/* record skip pointer needing to be set */
-	patch->state = &state->skip;
+	chunk1->patches = chunk2->patches;
+}
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+static inline void
+sub_chunk_zero_or_more(struct TastyChunk *const restrict chunk)
+{
+	struct TastyPatchList *const restrict chunk_patches = &chunk->patches;
 
-	/* patch match with start of self */
-	state->step[token] = state;
+	struct TastyPatch *const restrict chunk_patches_head
+	= chunk_patches->head;
+
+	patch_states(chunk_patches_head,
+		     chunk->start);
+
+	chunk_patches_head->state = &chunk->start->skip;
+	chunk_patches_head->next  = NULL_POINTER;
+	chunk_patches->end_ptr	  = &chunk_patches_head->next;
 }
 
 static inline void
-wild_zero_or_more(union TastyState *const restrict state,
-		  struct TastyPatch *restrict *const restrict patch_alloc,
-		  struct TastyPatch *restrict *const restrict patch_head)
+sub_chunk_one_or_more(struct TastyChunk *const restrict chunk,
+		      union TastyState *restrict *const restrict state_alloc,
+		      const size_t span)
+{
+	/* pop state node */
+	union TastyState *const restrict state = *state_alloc;
+	*state_alloc += span;
+
+	/* append state node that will loop on a match or skip */
+	copy_steps(state,
+		   chunk->start,
+		   span);
+
+	struct TastyPatchList *const restrict chunk_patches = &chunk->patches;
+	struct TastyPatch *const restrict chunk_patches_head
+	= chunk_patches->head;
+
+	patch_states(chunk_patches->head,
+		     state);
+
+	chunk_patches_head->state = &state->skip;
+	chunk_patches_head->next  = NULL_POINTER;
+	chunk_patches->end_ptr	  = &chunk_patches_head->next;
+}
+
+static inline void
+sub_chunk_zero_or_one(struct TastyChunk *const restrict chunk,
+		      struct TastyPatch *restrict *const restrict patch_alloc)
 {
 	/* pop patch node */
 	struct TastyPatch *const restrict patch = *patch_alloc;
 	++(*patch_alloc);
 
-	/* record skip pointer needing to be set */
-	patch->state = &state->skip;
+	/* record skip over entire chunk */
+	patch->state = &chunk->start->skip;
 
 	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
-
-	/* patch match with self */
-	join_wild_state(state,
-			state);
+	patch->next  = chunk->patches.head;
+	chunk->patches.head = patch;
 }
 
 static inline void
-match_wide_zero_or_more(union TastyState *const restrict state_first,
-			union TastyState *const restrict state_last,
-			struct TastyPatch *restrict *const restrict patch_alloc,
-			struct TastyPatch *restrict *const restrict patch_head,
-			const unsigned char token_last)
+push_wild_patches(struct TastyPatch *restrict *const restrict patch_head,
+		  struct TastyPatch *restrict *const restrict patch_alloc,
+		  union TastyState *const restrict state,
+		  const size_t span)
+{
+	struct TastyPatch *restrict patch;
+	struct TastyPatch *restrict next_patch;
+	union TastyState *restrict state_from;
+
+	/* init list traversal vars */
+	next_patch = *patch_head;
+	patch	   = *patch_alloc;
+
+	/* starting from first non-skip byte class */
+	state_from = state + 1l;
+
+	union TastyState *const restrict state_until = state + span;
+
+	do {
+		patch->state = &state_from->step;
+		patch->next  = next_patch;
+
+		next_patch = patch;
+		++patch;
+
+		++state_from;
+	} while (state_from < state_until);
+
+	/* update head of list, alloc */
+	*patch_head  = next_patch;
+	*patch_alloc = patch;
+}
+
+static inline void
+join_wild_state(union TastyState *const wild_state,
+		union TastyState *const next_state, /* may be 'wild_state' */
+		const size_t span)
+{
+	union TastyState *restrict state_from;
+
+	/* starting from first non-skip byte class */
+	state_from = wild_state + 1l;
+
+	union TastyState *const restrict state_until = wild_state + span;
+
+	do {
+		state_from->step = next_state;
+		++state_from;
+	} while (state_from < state_until);
+}
+
+static inline void
+push_set_patches(struct TastyPatch *restrict *const restrict patch_head,
+		 struct TastyPatch *restrict *const restrict patch_alloc,
+		 union TastyState *const restrict state,
+		 const size_t span,
+		 const uint64_t *const restrict class_set)
+{
+	struct TastyPatch *restrict patch;
+	struct TastyPatch *restrict next_patch;
+	size_t cls;
+
+	/* init list traversal vars */
+	next_patch = *patch_head;
+	patch	   = *patch_alloc;
+
+	for (cls = 0l; cls < (span - 1l); ++cls)
+		if (byte_set_has(class_set,
+				 (unsigned int) cls)) {
+			patch->state = &state[cls + 1l].step;
+			patch->next  = next_patch;
+
+			next_patch = patch;
+			++patch;
+		}
+
+	/* update head of list, alloc */
+	*patch_head  = next_patch;
+	*patch_alloc = patch;
+}
+
+static inline void
+join_set_state(union TastyState *const set_state,
+	       union TastyState *const next_state, /* may be 'set_state' */
+	       const size_t span,
+	       const uint64_t *const restrict class_set)
+{
+	size_t cls;
+
+	for (cls = 0l; cls < (span - 1l); ++cls)
+		if (byte_set_has(class_set,
+				 (unsigned int) cls))
+			set_state[cls + 1l].step = next_state;
+}
+
+
+/* fundamental state elements
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+match_one(union TastyState *const restrict state,
+	  struct TastyPatch *restrict *const restrict patch_alloc,
+	  struct TastyPatch *restrict *const restrict patch_head,
+	  const unsigned int token)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record pointer needing to be set */
+	patch->state = &state[token].step;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+}
+
+static inline void
+wild_one(union TastyState *const restrict state,
+	 struct TastyPatch *restrict *const restrict patch_alloc,
+	 struct TastyPatch *restrict *const restrict patch_head,
+	 const size_t span)
+{
+	/* push a patch node for every byte class */
+	push_wild_patches(patch_head,
+			  patch_alloc,
+			  state,
+			  span);
+}
+
+static inline void
+set_one(union TastyState *const restrict state,
+	struct TastyPatch *restrict *const restrict patch_alloc,
+	struct TastyPatch *restrict *const restrict patch_head,
+	const size_t span,
+	const uint64_t *const restrict class_set)
+{
+	/* push a patch node for every member byte class */
+	push_set_patches(patch_head,
+			 patch_alloc,
+			 state,
+			 span,
+			 class_set);
+}
+
+static inline void
+match_wide_one(union TastyState *const restrict state_last,
+	       struct TastyPatch *restrict *const restrict patch_alloc,
+	       struct TastyPatch *restrict *const restrict patch_head,
+	       const unsigned int token_last)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record pointer needing to be set */
+	patch->state = &state_last[token_last].step;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+}
+
+
+static inline void
+match_zero_or_one(union TastyState *const restrict state,
+		  struct TastyPatch *restrict *const restrict patch_alloc,
+		  struct TastyPatch *restrict *const restrict patch_head,
+		  const unsigned int token)
+{
+	struct TastyPatch *restrict patch;
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	*patch_alloc += 2l; /* account for second patch */
+
+	/* record skip pointer needing to be set */
+	patch->state = &state->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* pop patch node */
+	++patch;
+
+	/* record match pointer needing to be set */
+	patch->state = &state[token].step;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+}
+
+static inline void
+wild_zero_or_one(union TastyState *const restrict state,
+		 struct TastyPatch *restrict *const restrict patch_alloc,
+		 struct TastyPatch *restrict *const restrict patch_head,
+		 const size_t span)
+{
+	struct TastyPatch *restrict patch;
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* push a patch node for every byte class */
+	push_wild_patches(patch_head,
+			  patch_alloc,
+			  state,
+			  span);
+}
+
+static inline void
+set_zero_or_one(union TastyState *const restrict state,
+		struct TastyPatch *restrict *const restrict patch_alloc,
+		struct TastyPatch *restrict *const restrict patch_head,
+		const size_t span,
+		const uint64_t *const restrict class_set)
+{
+	struct TastyPatch *restrict patch;
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* push a patch node for every member byte class */
+	push_set_patches(patch_head,
+			 patch_alloc,
+			 state,
+			 span,
+			 class_set);
+}
+
+static inline void
+match_wide_zero_or_one(union TastyState *const restrict state_first,
+		       union TastyState *const restrict state_last,
+		       struct TastyPatch *restrict *const restrict patch_alloc,
+		       struct TastyPatch *restrict *const restrict patch_head,
+		       const unsigned int token_last)
+{
+	struct TastyPatch *restrict patch;
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	*patch_alloc += 2l; /* account for second patch */
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_first->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* pop patch node */
+	++patch;
+
+	/* record match pointer needing to be set */
+	patch->state = &state_last[token_last].step;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+}
+
+
+static inline void
+match_zero_or_more(union TastyState *const restrict state,
+		   struct TastyPatch *restrict *const restrict patch_alloc,
+		   struct TastyPatch *restrict *const restrict patch_head,
+		   const unsigned int token)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch match with start of self */
+	state[token].step = state;
+}
+
+static inline void
+wild_zero_or_more(union TastyState *const restrict state,
+		  struct TastyPatch *restrict *const restrict patch_alloc,
+		  struct TastyPatch *restrict *const restrict patch_head,
+		  const size_t span)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch match with self */
+	join_wild_state(state,
+			state,
+			span);
+}
+
+static inline void
+set_zero_or_more(union TastyState *const restrict state,
+		 struct TastyPatch *restrict *const restrict patch_alloc,
+		 struct TastyPatch *restrict *const restrict patch_head,
+		 const size_t span,
+		 const uint64_t *const restrict class_set)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch member matches with self */
+	join_set_state(state,
+		       state,
+		       span,
+		       class_set);
+}
+
+static inline void
+match_wide_zero_or_more(union TastyState *const restrict state_first,
+			union TastyState *const restrict state_last,
+			struct TastyPatch *restrict *const restrict patch_alloc,
+			struct TastyPatch *restrict *const restrict patch_head,
+			const unsigned int token_last)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_first->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch match with start of self */
+	state_last[token_last].step = state_first;
+}
+
+
+static inline void
+match_one_or_more(union TastyState *const restrict state_one,
+		  union TastyState *const restrict state_zero_or_more,
+		  struct TastyPatch *restrict *const restrict patch_alloc,
+		  struct TastyPatch *restrict *const restrict patch_head,
+		  const unsigned int token)
+{
+	struct TastyPatch *restrict patch;
+
+	/* patch first match */
+	state_one[token].step = state_zero_or_more;
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_zero_or_more->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch second state with self on match */
+	state_zero_or_more[token].step = state_zero_or_more;
+}
+
+static inline void
+wild_one_or_more(union TastyState *const restrict state_one,
+		 union TastyState *const restrict state_zero_or_more,
+		 struct TastyPatch *restrict *const restrict patch_alloc,
+		 struct TastyPatch *restrict *const restrict patch_head,
+		 const size_t span)
+{
+	struct TastyPatch *restrict patch;
+
+	/* patch first match */
+	join_wild_state(state_one,
+			state_zero_or_more,
+			span);
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_zero_or_more->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch second state with self on wild */
+	join_wild_state(state_zero_or_more,
+			state_zero_or_more,
+			span);
+}
+
+static inline void
+set_one_or_more(union TastyState *const restrict state_one,
+		union TastyState *const restrict state_zero_or_more,
+		struct TastyPatch *restrict *const restrict patch_alloc,
+		struct TastyPatch *restrict *const restrict patch_head,
+		const size_t span,
+		const uint64_t *const restrict class_set)
+{
+	struct TastyPatch *restrict patch;
+
+	/* patch first match */
+	join_set_state(state_one,
+		       state_zero_or_more,
+		       span,
+		       class_set);
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_zero_or_more->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch second state with self on member */
+	join_set_state(state_zero_or_more,
+		       state_zero_or_more,
+		       span,
+		       class_set);
+}
+
+static inline void
+match_wide_one_or_more(union TastyState *const restrict state_second,
+		       union TastyState *const restrict state_last,
+		       union TastyState *const restrict state_zero_or_more,
+		       struct TastyPatch *restrict *const restrict patch_alloc,
+		       struct TastyPatch *restrict *const restrict patch_head,
+		       const unsigned int token_first,
+		       const unsigned int token_last)
+{
+	struct TastyPatch *restrict patch;
+
+	/* patch first match */
+	state_last[token_last].step = state_zero_or_more;
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_zero_or_more->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch looping state with second in chain */
+	state_zero_or_more[token_first].step = state_second;
+}
+
+
+/* two-byte letters matching either case, stepping into 'state_last1' or
+ * 'state_last2' on their lead bytes 'token_first1', 'token_first2' and
+ * completing on tail bytes 'token_last1', 'token_last2' */
+static inline void
+fold_wide_one(union TastyState *const restrict state_last1,
+	      union TastyState *const restrict state_last2,
+	      struct TastyPatch *restrict *const restrict patch_alloc,
+	      struct TastyPatch *restrict *const restrict patch_head,
+	      const unsigned int token_last1,
+	      const unsigned int token_last2)
+{
+	struct TastyPatch *restrict patch;
+
+	/* pop patch node */
+	 patch = *patch_alloc;
+	*patch_alloc += 2l; /* account for second patch */
+
+	/* record match pointers needing to be set */
+	patch->state = &state_last1[token_last1].step;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* pop patch node */
+	++patch;
+
+	patch->state = &state_last2[token_last2].step;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+}
+
+static inline void
+fold_wide_zero_or_one(union TastyState *const restrict state_first,
+		      union TastyState *const restrict state_last1,
+		      union TastyState *const restrict state_last2,
+		      struct TastyPatch *restrict *const restrict patch_alloc,
+		      struct TastyPatch *restrict *const restrict patch_head,
+		      const unsigned int token_last1,
+		      const unsigned int token_last2)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_first->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	fold_wide_one(state_last1,
+		      state_last2,
+		      patch_alloc,
+		      patch_head,
+		      token_last1,
+		      token_last2);
+}
+
+static inline void
+fold_wide_zero_or_more(union TastyState *const restrict state_first,
+		       union TastyState *const state_last1,
+		       union TastyState *const state_last2,
+		       struct TastyPatch *restrict *const restrict patch_alloc,
+		       struct TastyPatch *restrict *const restrict patch_head,
+		       const unsigned int token_last1,
+		       const unsigned int token_last2)
+{
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_first->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch matches with start of self */
+	state_last1[token_last1].step = state_first;
+	state_last2[token_last2].step = state_first;
+}
+
+static inline void
+fold_wide_one_or_more(union TastyState *const state_last1,
+		      union TastyState *const state_last2,
+		      union TastyState *const restrict state_zero_or_more,
+		      struct TastyPatch *restrict *const restrict patch_alloc,
+		      struct TastyPatch *restrict *const restrict patch_head,
+		      const unsigned int token_first1,
+		      const unsigned int token_first2,
+		      const unsigned int token_last1,
+		      const unsigned int token_last2)
+{
+	/* patch first matches */
+	state_last1[token_last1].step = state_zero_or_more;
+	state_last2[token_last2].step = state_zero_or_more;
+
+	/* pop patch node */
+	struct TastyPatch *const restrict patch = *patch_alloc;
+	++(*patch_alloc);
+
+	/* record skip pointer needing to be set */
+	patch->state = &state_zero_or_more->skip;
+
+	/* push patch into head of patch_list */
+	patch->next = *patch_head;
+	*patch_head = patch;
+
+	/* patch looping state with tail states */
+	state_zero_or_more[token_first1].step = state_last1;
+	state_zero_or_more[token_first2].step = state_last2;
+}
+
+
+
+/* flatten 'skip' routes: overlay each state with the explicit matches found
+ * by skipping and flag states from which skipping reaches the matching state
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+overlay_skipped_steps(union TastyState *restrict state_from,
+		      const union TastyState *restrict skipped_from,
+		      const size_t span)
+{
+	const union TastyState *const restrict state_until = state_from + span;
+
+	while (1) {
+		++state_from;
+		if (state_from == state_until)
+			return;
+
+		++skipped_from;
+
+		/* explicit match in state takes precedence over skipping */
+		if (state_from->step == NULL_POINTER)
+			state_from->step = skipped_from->step;
+	}
+}
+
+static inline void
+flatten_skips(unsigned char *const restrict marks,
+	      size_t *const restrict stack,
+	      union TastyState *const restrict state_base,
+	      const union TastyState *const restrict state_until,
+	      const size_t span)
+{
+	union TastyState *restrict state;
+	const union TastyState *restrict skipped;
+	size_t *restrict stack_top;
+	size_t row;
+	size_t next_row;
+
+	const size_t count_rows = (state_until - state_base) / span;
+
+	for (row = 0l; row < count_rows; ++row) {
+		if (marks[row] & TASTY_MARK_FLATTENED)
+			continue;
+
+		/* push skip route until it leaves unflattened states (or cycles
+		 * back into itself) */
+		stack_top = stack;
+		next_row  = row;
+
+		while (1) {
+			marks[next_row] |= TASTY_MARK_ON_STACK;
+			*stack_top = next_row;
+			++stack_top;
+
+			skipped = state_base[next_row * span].skip;
+
+			if (   (skipped == NULL_POINTER)
+			    || (skipped == state_until))
+				break;
+
+			next_row = (skipped - state_base) / span;
+
+			if (marks[next_row] & (  TASTY_MARK_FLATTENED
+					       | TASTY_MARK_ON_STACK))
+				break;
+		}
+
+		/* pop route, flattening from the end of the route backwards */
+		do {
+			--stack_top;
+			next_row = *stack_top;
+			state	 = state_base + (next_row * span);
+			skipped	 = state->skip;
+
+			if (skipped == state_until) {
+				marks[next_row] |= TASTY_MARK_ACCEPTING;
+
+			} else if (skipped != NULL_POINTER) {
+				const size_t skipped_row
+				= (skipped - state_base) / span;
+
+				/* skip route cycling back is a dead end */
+				if (marks[skipped_row] & TASTY_MARK_FLATTENED) {
+					overlay_skipped_steps(state,
+							      skipped,
+							      span);
+
+					marks[next_row]
+					|= (  marks[skipped_row]
+					    & TASTY_MARK_ACCEPTING);
+				}
+			}
+
+			marks[next_row] = (marks[next_row]
+					   & ~TASTY_MARK_ON_STACK)
+					| TASTY_MARK_FLATTENED;
+		} while (stack_top > stack);
+	}
+}
+
+
+/* minimize DFA: partition rows into classes of rows that step to equivalent
+ * rows on every byte class and agree on closing matches (Hopcroft)
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline uint32_t
+state_index(const union TastyState *const restrict state,
+	    const union TastyState *const restrict state_base,
+	    const union TastyState *const restrict state_until,
+	    const size_t node_span)
+{
+	const size_t count_rows = (state_until - state_base) / node_span;
+
+	if (state == NULL_POINTER)
+		return (uint32_t) (count_rows + 1l); /* dead end */
+
+	return (uint32_t) ((state - state_base) / node_span); /* or matching */
+}
+
+static inline uint32_t
+state_target(const union TastyState *const restrict state_base,
+	     const union TastyState *const restrict state_until,
+	     const size_t node_span,
+	     const uint32_t index,
+	     const size_t token)
+{
+	const size_t count_rows = (state_until - state_base) / node_span;
+
+	/* matching and dead end step nowhere */
+	if (index >= count_rows)
+		return (uint32_t) (count_rows + 1l);
+
+	return state_index(state_base[(index * node_span) + token + 1l].step,
+			   state_base,
+			   state_until,
+			   node_span);
+}
+
+/* leaders[row] ← least row equivalent to 'row' (rows 0 … count_rows, the last
+ * being matching) */
+static inline int
+minimize_states(uint32_t *const restrict leaders,
+		const unsigned char *const restrict marks,
+		const union TastyState *const restrict state_base,
+		const union TastyState *const restrict state_until,
+		const size_t node_span)
+{
+	uint32_t *restrict pred;
+	uint32_t *restrict pred_until;
+	uint32_t state;
+	uint32_t target;
+	uint32_t block;
+	uint32_t split;
+	uint32_t from;
+	uint32_t until;
+	uint32_t marked;
+	uint32_t count_blocks;
+	uint32_t count_pending;
+	uint32_t count_splitter;
+	uint32_t count_touched;
+	size_t token;
+	size_t edge;
+
+	const size_t span	  = node_span - 1l;
+	const size_t count_rows	  = (state_until - state_base) / node_span;
+	const uint32_t matching	  = (uint32_t) count_rows;
+	const uint32_t dead	  = matching + 1u;
+	const uint32_t count_all  = dead + 1u;
+	const size_t count_edges  = count_all * span;
+
+	/* predecessors on each (target, class), state partition, blocks,
+	 * worklist */
+	uint32_t *const restrict pred_index
+	= malloc(sizeof(uint32_t) * ((count_edges * 2l) + 1l
+				     + (count_all * 10l)));
+
+	if (UNLIKELY(pred_index == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	uint32_t *const restrict preds	      = pred_index + count_edges + 1l;
+	uint32_t *const restrict elems	      = preds + count_edges;
+	uint32_t *const restrict locs	      = elems + count_all;
+	uint32_t *const restrict blocks	      = locs + count_all;
+	uint32_t *const restrict block_from   = blocks + count_all;
+	uint32_t *const restrict block_until  = block_from + count_all;
+	uint32_t *const restrict block_marked = block_until + count_all;
+	uint32_t *const restrict pending      = block_marked + count_all;
+	uint32_t *const restrict is_pending   = pending + count_all;
+	uint32_t *const restrict touched      = is_pending + count_all;
+	uint32_t *const restrict splitter     = touched + count_all;
+
+	/* invert transitions: count, sum, then fill backwards */
+	(void) memset(pred_index,
+		      0,
+		      sizeof(uint32_t) * (count_edges + 1l));
+
+	for (state = 0u; state < count_all; ++state)
+		for (token = 0l; token < span; ++token)
+			++pred_index[(state_target(state_base,
+						   state_until,
+						   node_span,
+						   state,
+						   token) * span) + token];
+
+	for (edge = 1l; edge < count_edges; ++edge)
+		pred_index[edge] += pred_index[edge - 1l];
+
+	pred_index[count_edges] = (uint32_t) count_edges;
+
+	for (state = 0u; state < count_all; ++state)
+		for (token = 0l; token < span; ++token) {
+			edge = (state_target(state_base,
+					     state_until,
+					     node_span,
+					     state,
+					     token) * span) + token;
+			--pred_index[edge];
+			preds[pred_index[edge]] = state;
+		}
+
+	/* initial partition: block 0 never closes, block 1 closes matches,
+	 * block 2 holds the dead end alone (stepping into any row, even one
+	 * that can never match, keeps a predecessor from closing its match) */
+	from  = 0u;
+	until = dead;
+
+	for (state = 0u; state < dead; ++state) {
+		if (   (state == matching)
+		    || (marks[state] & TASTY_MARK_ACCEPTING)) {
+			--until;
+			elems[until] = state;
+			locs[state]  = until;
+			blocks[state] = 1u;
+		} else {
+			elems[from]   = state;
+			locs[state]   = from;
+			blocks[state] = 0u;
+			++from;
+		}
+	}
+
+	elems[dead]  = dead;
+	locs[dead]   = dead;
+	blocks[dead] = 2u;
+
+	block_from[0]	= 0u;
+	block_until[0]	= from;
+	block_from[1]	= from;
+	block_until[1]	= dead;
+	block_from[2]	= dead;
+	block_until[2]	= count_all;
+	block_marked[0] = 0u;
+	block_marked[1] = 0u;
+	block_marked[2] = 0u;
+	pending[0]	= 0u;
+	pending[1]	= 1u;
+	pending[2]	= 2u;
+	is_pending[0]	= 1u;
+	is_pending[1]	= 1u;
+	is_pending[2]	= 1u;
+	count_blocks	= 3u;
+	count_pending	= 3u;
+
+	while (count_pending > 0u) {
+		--count_pending;
+		block		  = pending[count_pending];
+		is_pending[block] = 0u;
+
+		/* splitter may itself be split while refining */
+		count_splitter = block_until[block] - block_from[block];
+		(void) memcpy(splitter,
+			      &elems[block_from[block]],
+			      sizeof(uint32_t) * count_splitter);
+
+		for (token = 0l; token < span; ++token) {
+			count_touched = 0u;
+
+			/* move predecessors on 'token' to front of their block */
+			for (target = 0u; target < count_splitter; ++target) {
+				edge	   = (splitter[target] * span) + token;
+				pred	   = &preds[pred_index[edge]];
+				pred_until = &preds[pred_index[edge + 1l]];
+
+				for (; pred < pred_until; ++pred) {
+					state  = *pred;
+					block  = blocks[state];
+					marked = block_from[block]
+					       + block_marked[block];
+
+					if (locs[state] < marked)
+						continue; /* already moved */
+
+					if (block_marked[block] == 0u) {
+						touched[count_touched] = block;
+						++count_touched;
+					}
+
+					/* swap with first unmarked element */
+					elems[locs[state]]   = elems[marked];
+					locs[elems[marked]]  = locs[state];
+					elems[marked]	     = state;
+					locs[state]	     = marked;
+					++block_marked[block];
+				}
+			}
+
+			/* split touched blocks, relabeling the smaller half */
+			while (count_touched > 0u) {
+				--count_touched;
+				block  = touched[count_touched];
+				from   = block_from[block];
+				until  = block_until[block];
+				marked = from + block_marked[block];
+
+				block_marked[block] = 0u;
+
+				if (marked == until)
+					continue; /* every member stepped */
+
+				split = count_blocks;
+				++count_blocks;
+				block_marked[split] = 0u;
+
+				if ((marked - from) <= (until - marked)) {
+					block_from[split]  = from;
+					block_until[split] = marked;
+					block_from[block]  = marked;
+				} else {
+					block_from[split]  = marked;
+					block_until[split] = until;
+					block_until[block] = marked;
+				}
+
+				for (state = block_from[split];
+				     state < block_until[split];
+				     ++state)
+					blocks[elems[state]] = split;
+
+				/* refine on new half, or both if pending */
+				is_pending[split]      = 1u;
+				pending[count_pending] = split;
+				++count_pending;
+
+				if (   !is_pending[block]
+				    && (  (block_until[block]
+					   - block_from[block])
+					< (block_until[split]
+					   - block_from[split]))) {
+					/* swap roles: refine on smaller */
+					is_pending[split]	       = 0u;
+					is_pending[block]	       = 1u;
+					pending[count_pending - 1u] = block;
+				}
+			}
+		}
+	}
+
+	/* leader of each block is its least row */
+	for (block = 0u; block < count_blocks; ++block)
+		block_marked[block] = TASTY_ROW_UNSET;
+
+	for (state = 0u; state < dead; ++state) {
+		block = blocks[state];
+
+		if (block_marked[block] == TASTY_ROW_UNSET)
+			block_marked[block] = state;
+
+		leaders[state] = block_marked[block];
+	}
+
+	free(pred_index);
+
+	return 0;
+}
+
+
+/* extract literals: 'prefix' follows the table from the initial row while
+ * each row steps on a single class of a single byte and cannot close a match.
+ * Every match passes through each row that dominates the closing of matches,
+ * so the bytes forced from such a row form a literal every match contains.
+ * ────────────────────────────────────────────────────────────────────────── */
+/* targets of row 'state', 'count' cells (dead ends included for dense rows) */
+static inline const uint32_t *
+row_targets(const uint32_t *const restrict states,
+	    const uint32_t state,
+	    const uint32_t span,
+	    uint32_t *const restrict count)
+{
+	const uint32_t *const restrict row = &states[state & TASTY_STATE_OFFSET];
+
+	if (state & TASTY_STATE_SPARSE) {
+		*count = row[0];
+		return row + 1u + row[0];
+	}
+
+	*count = span;
+	return row;
+}
+
+/* bytes every path leaving 'state' steps on before it can close a match */
+static inline uint32_t
+forced_literal(const struct TastyRegex *const restrict regex,
+	       const uint32_t *const restrict count_bytes,
+	       const unsigned char *const restrict byte_of,
+	       uint32_t state,
+	       unsigned char *const restrict literal)
+{
+	const uint32_t *restrict row;
+	uint32_t length;
+	uint32_t cls;
+	uint32_t live_class;
+	uint32_t live_target;
+	uint32_t count_live;
+
+	const uint32_t span = regex->span;
+
+	length = 0u;
+
+	while (length < TASTY_LITERAL_LENGTH_MAX) {
+		row	    = &regex->states[state & TASTY_STATE_OFFSET];
+		count_live  = 0u;
+		live_class  = 0u;
+		live_target = 0u;
+
+		if (state & TASTY_STATE_SPARSE) {
+			count_live = row[0];
+
+			if (count_live == 1u) {
+				live_class  = row[1];
+				live_target = row[2];
+			}
+
+		} else {
+			for (cls = 0u; cls < span; ++cls)
+				if (row[cls] != 0u) {
+					++count_live;
+					live_class  = cls;
+					live_target = row[cls];
+				}
+		}
+
+		if (   (count_live != 1u)
+		    || (live_target == 0u)
+		    || (count_bytes[live_class] != 1u))
+			break;
+
+		literal[length] = byte_of[live_class];
+		++length;
+
+		/* a match may close here, following bytes are optional */
+		if (live_target & TASTY_STATE_ACCEPTING)
+			break;
+
+		state = live_target;
+	}
+
+	return length;
+}
+
+/* walk up dominator tree from 'node1' and 'node2' to their nearest common
+ * dominator (Cooper, Harvey, Kennedy) */
+static inline uint32_t
+dominator_intersect(const uint32_t *const restrict idoms,
+		    const uint32_t *const restrict order,
+		    uint32_t node1,
+		    uint32_t node2)
+{
+	/* dominators follow their nodes in postorder */
+	while (node1 != node2) {
+		while (order[node1] < order[node2])
+			node1 = idoms[node1];
+
+		while (order[node2] < order[node1])
+			node2 = idoms[node2];
+	}
+
+	return node1;
+}
+
+/* length of shortest path from root (node 0) to 'node' */
+static inline uint32_t
+literal_lead_min(const struct TastyRowGraph *const restrict graph,
+		 const uint32_t node)
+{
+	uint32_t *restrict queue_head;
+	uint32_t *restrict queue_tail;
+	uint32_t from;
+	uint32_t edge;
+	uint32_t next;
+
+	uint32_t *const restrict distances = graph->longest;
+	uint32_t *const restrict queue	   = graph->queue;
+
+	(void) memset(distances,
+		      0xff,
+		      sizeof(uint32_t) * graph->count_nodes);
+
+	distances[0] = 0u;
+	*queue	     = 0u;
+	queue_tail   = queue + 1l;
+
+	for (queue_head = queue; queue_head < queue_tail; ++queue_head) {
+		from = *queue_head;
+
+		if (from == node)
+			break;
+
+		for (edge = graph->succ_start[from];
+		     edge < graph->succ_start[from + 1u];
+		     ++edge) {
+			next = graph->succ[edge];
+
+			if (distances[next] == UINT32_MAX) {
+				distances[next] = distances[from] + 1u;
+				*queue_tail	= next;
+				++queue_tail;
+			}
+		}
+	}
+
+	return distances[node];
+}
+
+/* longest path from root (node 0) that enters 'node' only at its end, or
+ * TASTY_LEAD_UNBOUNDED if such paths may cycle */
+static inline uint32_t
+literal_lead_max(const struct TastyRowGraph *const restrict graph,
+		 const uint32_t node)
+{
+	uint32_t *restrict queue_head;
+	uint32_t *restrict queue_tail;
+	uint32_t count_inner;
+	uint32_t from;
+	uint32_t edge;
+	uint32_t next;
+
+	const uint32_t count_nodes	  = graph->count_nodes;
+	const uint32_t *const restrict succ_start = graph->succ_start;
+	const uint32_t *const restrict succ	  = graph->succ;
+	const uint32_t *const restrict pred_start = graph->pred_start;
+	const uint32_t *const restrict pred	  = graph->pred;
+	uint32_t *const restrict marks		  = graph->marks;
+	uint32_t *const restrict in_degree	  = graph->in_degree;
+	uint32_t *const restrict longest	  = graph->longest;
+	uint32_t *const restrict queue		  = graph->queue;
+
+	(void) memset(marks,
+		      0,
+		      sizeof(uint32_t) * count_nodes);
+
+	/* mark 1: reachable from root without passing 'node' */
+	marks[0]   = 1u;
+	*queue	   = 0u;
+	queue_tail = queue + 1l;
+
+	for (queue_head = queue; queue_head < queue_tail; ++queue_head) {
+		from = *queue_head;
+
+		if (from == node)
+			continue;
+
+		for (edge = succ_start[from];
+		     edge < succ_start[from + 1u];
+		     ++edge) {
+			next = succ[edge];
+
+			if (!(marks[next] & 1u)) {
+				marks[next] |= 1u;
+				*queue_tail  = next;
+				++queue_tail;
+			}
+		}
+	}
+
+	/* mark 2: reaches 'node' without passing it */
+	marks[node] |= 2u;
+	*queue	     = node;
+	queue_tail   = queue + 1l;
+
+	for (queue_head = queue; queue_head < queue_tail; ++queue_head) {
+		from = *queue_head;
+
+		for (edge = pred_start[from];
+		     edge < pred_start[from + 1u];
+		     ++edge) {
+			next = pred[edge];
+
+			if ((next != node) && !(marks[next] & 2u)) {
+				marks[next] |= 2u;
+				*queue_tail  = next;
+				++queue_tail;
+			}
+		}
+	}
+
+	/* longest path over nodes marked both ways (Kahn's algorithm) */
+	count_inner = 0u;
+
+	for (from = 0u; from < count_nodes; ++from) {
+		in_degree[from] = 0u;
+		longest[from]	= 0u;
+	}
+
+	for (from = 0u; from < count_nodes; ++from) {
+		if (marks[from] != 3u)
+			continue;
+
+		++count_inner;
+
+		if (from == node)
+			continue;
+
+		for (edge = succ_start[from];
+		     edge < succ_start[from + 1u];
+		     ++edge)
+			if (marks[succ[edge]] == 3u)
+				++in_degree[succ[edge]];
+	}
+
+	queue_tail = queue;
+
+	for (from = 0u; from < count_nodes; ++from)
+		if ((marks[from] == 3u) && (in_degree[from] == 0u)) {
+			*queue_tail = from;
+			++queue_tail;
+		}
+
+	for (queue_head = queue; queue_head < queue_tail; ++queue_head) {
+		from = *queue_head;
+
+		if (from == node)
+			continue;
+
+		for (edge = succ_start[from];
+		     edge < succ_start[from + 1u];
+		     ++edge) {
+			next = succ[edge];
+
+			if (marks[next] != 3u)
+				continue;
+
+			if (longest[next] < (longest[from] + 1u))
+				longest[next] = longest[from] + 1u;
+
+			--in_degree[next];
+
+			if (in_degree[next] == 0u) {
+				*queue_tail = next;
+				++queue_tail;
+			}
+		}
+	}
+
+	/* some node left unsorted: on a cycle */
+	return (((uint32_t) (queue_tail - queue)) < count_inner)
+	     ? TASTY_LEAD_UNBOUNDED
+	     : longest[node];
+}
+
+/* graph of rows reachable from the initial row (node 0), plus a closing
+ * node stepped to from every accepting row, and its dominator tree */
+static inline int
+row_graph_init(struct TastyRowGraph *const restrict graph,
+		   const struct TastyRegex *const restrict regex,
+		   const size_t length_table)
+{
+	const uint32_t *restrict targets;
+	const uint32_t *restrict target;
+	uint32_t *restrict rows;
+	uint32_t *restrict index_of;
+	uint32_t *restrict stack_top;
+	uint32_t count_targets;
+	uint32_t count_rows;
+	uint32_t count_edges;
+	uint32_t node;
+	uint32_t next;
+	uint32_t edge;
+	uint32_t count_order;
+	uint32_t idom;
+	bool changed;
+
+	const uint32_t span = regex->span;
+
+	/* row index by offset, rows in order found */
+	index_of = malloc(sizeof(uint32_t) * length_table * 2l);
+
+	if (UNLIKELY(index_of == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	rows = index_of + length_table;
+
+	(void) memset(index_of,
+		      0xff,
+		      sizeof(uint32_t) * length_table);
+
+	index_of[regex->initial & TASTY_STATE_OFFSET] = 0u;
+	rows[0]	    = regex->initial;
+	count_rows  = 1u;
+	count_edges = 0u;
+
+	for (node = 0u; node < count_rows; ++node) {
+		targets = row_targets(regex->states,
+				      rows[node],
+				      span,
+				      &count_targets);
+
+		count_edges += (rows[node] & TASTY_STATE_ACCEPTING) != 0u;
+
+		for (target = targets;
+		     target < targets + count_targets;
+		     ++target) {
+			if (*target == 0u)
+				continue;
+
+			++count_edges;
+
+			if (index_of[*target & TASTY_STATE_OFFSET] == UINT32_MAX) {
+				index_of[*target & TASTY_STATE_OFFSET]
+				= count_rows;
+				rows[count_rows] = *target;
+				++count_rows;
+			}
+		}
+	}
+
+	/* closing node follows rows */
+	const uint32_t count_nodes = count_rows + 1u;
+
+	/* succ|pred starts, succ|pred, order, idoms, marks, in_degree,
+	 * longest, queue, stack */
+	uint32_t *const restrict buffer
+	= malloc(sizeof(uint32_t) * (  (2l * (count_nodes + 1l))
+				     + (2l * count_edges)
+				     + (7l * count_nodes)));
+
+	if (UNLIKELY(buffer == NULL_POINTER)) {
+		free(index_of);
+		return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	graph->count_nodes = count_nodes;
+	graph->rows	   = rows;
+	graph->index_of	   = index_of;
+	graph->succ_start  = buffer;
+	graph->succ	   = graph->succ_start + count_nodes + 1u;
+	graph->pred_start  = graph->succ + count_edges;
+	graph->pred	   = graph->pred_start + count_nodes + 1u;
+	graph->order	   = graph->pred + count_edges;
+	graph->idoms	   = graph->order + count_nodes;
+	graph->marks	   = graph->idoms + count_nodes;
+	graph->in_degree   = graph->marks + count_nodes;
+	graph->longest	   = graph->in_degree + count_nodes;
+	graph->queue	   = graph->longest + count_nodes;
+	stack_top	   = graph->queue + count_nodes;
+
+	uint32_t *const restrict succ_start = graph->succ_start;
+	uint32_t *const restrict succ	    = graph->succ;
+	uint32_t *const restrict pred_start = graph->pred_start;
+	uint32_t *const restrict pred	    = graph->pred;
+	uint32_t *const restrict order	    = graph->order;
+	uint32_t *const restrict idoms	    = graph->idoms;
+	uint32_t *const restrict queue	    = graph->queue;
+	uint32_t *const restrict cursors    = graph->longest;
+	uint32_t *const restrict stack	    = stack_top;
+
+	/* successors */
+	edge = 0u;
+
+	for (node = 0u; node < count_rows; ++node) {
+		succ_start[node] = edge;
+
+		targets = row_targets(regex->states,
+				      rows[node],
+				      span,
+				      &count_targets);
+
+		for (target = targets;
+		     target < targets + count_targets;
+		     ++target)
+			if (*target != 0u) {
+				succ[edge]
+				= index_of[*target & TASTY_STATE_OFFSET];
+				++edge;
+			}
+
+		if (rows[node] & TASTY_STATE_ACCEPTING) {
+			succ[edge] = count_rows;
+			++edge;
+		}
+	}
+
+	succ_start[count_rows]	= edge;
+	succ_start[count_nodes] = edge;
+
+	/* predecessors, counted then placed */
+	(void) memset(pred_start,
+		      0,
+		      sizeof(uint32_t) * (count_nodes + 1l));
+
+	for (edge = 0u; edge < count_edges; ++edge)
+		++pred_start[succ[edge] + 1u];
+
+	for (node = 0u; node < count_nodes; ++node)
+		pred_start[node + 1u] += pred_start[node];
+
+	(void) memcpy(queue,
+		      pred_start,
+		      sizeof(uint32_t) * count_nodes);
+
+	for (node = 0u; node < count_rows; ++node)
+		for (edge = succ_start[node];
+		     edge < succ_start[node + 1u];
+		     ++edge) {
+			pred[queue[succ[edge]]] = node;
+			++queue[succ[edge]];
+		}
+
+	/* postorder numbers (closing node unreached until numbered) */
+	(void) memset(order,
+		      0xff,
+		      sizeof(uint32_t) * count_nodes);
+
+	(void) memset(idoms,
+		      0xff,
+		      sizeof(uint32_t) * count_nodes);
+
+	count_order = 0u;
+	stack_top   = stack;
+	*stack_top  = 0u;
+	cursors[0]  = succ_start[0];	/* next edge of each node on stack */
+	idoms[0]    = 0u;		/* marks visited until dominators set */
+
+	while (1) {
+		node = *stack_top;
+
+		if (cursors[node] < succ_start[node + 1u]) {
+			next = succ[cursors[node]];
+			++cursors[node];
+
+			if (idoms[next] == UINT32_MAX) {
+				idoms[next]   = 0u;
+				cursors[next] = succ_start[next];
+				++stack_top;
+				*stack_top  = next;
+			}
+
+			continue;
+		}
+
+		order[node] = count_order;
+		queue[count_order] = node;	/* queue ← postorder */
+		++count_order;
+
+		if (stack_top == stack)
+			break;
+
+		--stack_top;
+	}
+
+	/* dominators, iterating in reverse postorder until stable */
+	(void) memset(idoms,
+		      0xff,
+		      sizeof(uint32_t) * count_nodes);
+
+	idoms[0] = 0u;
+
+	do {
+		changed = false;
+
+		for (next = count_order - 1u; next-- > 0u;) {
+			node = queue[next];
+			idom = UINT32_MAX;
+
+			for (edge = pred_start[node];
+			     edge < pred_start[node + 1u];
+			     ++edge) {
+				if (idoms[pred[edge]] == UINT32_MAX)
+					continue;
+
+				idom = (idom == UINT32_MAX)
+				     ? pred[edge]
+				     : dominator_intersect(idoms,
+							   order,
+							   pred[edge],
+							   idom);
+			}
+
+			if (idoms[node] != idom) {
+				idoms[node] = idom;
+				changed	    = true;
+			}
+		}
+	} while (changed);
+
+	return 0;
+}
+
+static inline void
+row_graph_free(struct TastyRowGraph *const restrict graph)
+{
+	free(graph->succ_start);
+	free(graph->index_of);
+}
+
+/* 'graph' is NULL_POINTER if the table is too large to analyze */
+static inline void
+extract_literals(struct TastyRegex *const restrict regex,
+		 const struct TastyRowGraph *const restrict graph)
+{
+	uint32_t count_bytes[UCHAR_MAX + 1];
+	unsigned char byte_of[UCHAR_MAX + 1];
+	unsigned char literal[TASTY_LITERAL_LENGTH_MAX];
+	uint32_t length_literal;
+	uint32_t lead_max;
+	uint32_t node;
+	unsigned int token;
+
+	/* tally bytes per class, remember a representative byte */
+	(void) memset(&count_bytes[0],
+		      0,
+		      sizeof(uint32_t) * regex->span);
+
+	for (token = 0u; token <= UCHAR_MAX; ++token) {
+		++count_bytes[regex->classes[token]];
+		byte_of[regex->classes[token]] = (unsigned char) token;
+	}
+
+	regex->length_prefix = forced_literal(regex,
+					      &count_bytes[0],
+					      &byte_of[0],
+					      regex->initial,
+					      &regex->prefix[0]);
+
+	/* prefix leads every match, unless a better literal is found */
+	(void) memcpy(&regex->inner[0],
+		      &regex->prefix[0],
+		      regex->length_prefix);
+
+	regex->length_inner   = regex->length_prefix;
+	regex->inner_lead_min = 0u;
+	regex->inner_lead_max = 0u;
+
+	if (graph == NULL_POINTER)
+		return;
+
+	const uint32_t count_rows = graph->count_nodes - 1u;
+
+	/* every dominator of closing node (besides initial row, done) */
+	for (node = graph->idoms[count_rows];
+	     (node != UINT32_MAX) && (node != 0u);
+	     node = graph->idoms[node]) {
+		/* matches may close on arrival */
+		if (graph->rows[node] & TASTY_STATE_ACCEPTING)
+			continue;
+
+		length_literal = forced_literal(regex,
+						&count_bytes[0],
+						&byte_of[0],
+						graph->rows[node],
+						&literal[0]);
+
+		if (length_literal == 0u)
+			continue;
+
+		/* bounded leads win over unbounded, then longer literals */
+		if (   (length_literal <= regex->length_inner)
+		    && (regex->inner_lead_max != TASTY_LEAD_UNBOUNDED))
+			continue;
+
+		lead_max = literal_lead_max(graph,
+					    node);
+
+		if (   (lead_max == TASTY_LEAD_UNBOUNDED)
+		    && (   (regex->length_inner > 0u)
+		        && (   (regex->inner_lead_max != TASTY_LEAD_UNBOUNDED)
+			    || (length_literal <= regex->length_inner))))
+			continue;
+
+		(void) memcpy(&regex->inner[0],
+			      &literal[0],
+			      length_literal);
+
+		regex->length_inner   = length_literal;
+		regex->inner_lead_min = literal_lead_min(graph,
+							 node);
+		regex->inner_lead_max = lead_max;
+	}
+}
+
+
+/* row set: tables of at most TASTY_ROW_SET_MAX rows are also stored as a
+ * dense byte matrix indexed by class and row number, so that runs may track
+ * the rows occupied by running matches in a single 64-bit word
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline int
+build_row_set(struct TastyRegex *const restrict regex,
+	      const struct TastyRowGraph *const restrict graph)
+{
+	const uint32_t *restrict row;
+	const uint32_t *restrict targets;
+	unsigned char *restrict steps;
+	uint64_t *restrict preds;
+	uint64_t *restrict closing;
+	uint32_t count_targets;
+	uint32_t node;
+	uint32_t cls;
+	uint32_t target;
+	unsigned int next_row;
+
+	const uint32_t span	  = regex->span;
+	const uint32_t count_rows = graph->count_nodes - 1u;
+
+	if (count_rows > TASTY_ROW_SET_MAX)
+		return 0;
+
+	/* row_steps[class × count_rows + row] ← next row or TASTY_ROW_SET_DEAD */
+	steps = malloc(sizeof(unsigned char) * span * count_rows);
+
+	if (UNLIKELY(steps == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	/* row_preds[class × count_rows + row], then rows_closing[class] */
+	preds = calloc(span * (count_rows + 1u),
+		       sizeof(uint64_t));
+
+	if (UNLIKELY(preds == NULL_POINTER)) {
+		free(steps);
+		return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	closing = preds + (span * count_rows);
+
+	(void) memset(steps,
+		      TASTY_ROW_SET_DEAD,
+		      sizeof(unsigned char) * span * count_rows);
+
+	regex->rows_accepting = 0u;
+
+	for (node = 0u; node < count_rows; ++node) {
+		row	= &regex->states[graph->rows[node] & TASTY_STATE_OFFSET];
+		targets = row_targets(regex->states,
+				      graph->rows[node],
+				      span,
+				      &count_targets);
+
+		for (cls = 0u; cls < count_targets; ++cls) {
+			target = targets[cls];
+
+			if (target == 0u)
+				continue;
+
+			/* sparse rows list their classes ahead of targets */
+			steps[  (  (graph->rows[node] & TASTY_STATE_SPARSE)
+				 ? row[1u + cls]
+				 : cls) * count_rows
+			      + node]
+			= (unsigned char) graph->index_of[target
+							  & TASTY_STATE_OFFSET];
+		}
+
+		if (graph->rows[node] & TASTY_STATE_ACCEPTING)
+			regex->rows_accepting |= UINT64_C(1) << node;
+	}
+
+	/* reverse steps, accepting rows closing on each class */
+	for (cls = 0u; cls < span; ++cls) {
+		for (node = 0u; node < count_rows; ++node) {
+			next_row = steps[(cls * count_rows) + node];
+
+			if (next_row != TASTY_ROW_SET_DEAD)
+				preds[(cls * count_rows) + next_row]
+				|= UINT64_C(1) << node;
+			else if (regex->rows_accepting & (UINT64_C(1) << node))
+				closing[cls] |= UINT64_C(1) << node;
+		}
+	}
+
+	regex->row_steps      = steps;
+	regex->row_preds      = preds;
+	regex->rows_closing   = closing;
+	regex->count_set_rows = count_rows;
+
+	return 0;
+}
+
+
+/* start set: bytes on which the initial row steps, as a pair of nibble
+ * tables (shufti) — byte B may begin a match if
+ * (start_low[B & 0xf] & start_high[B >> 4]) != 0.  High nibbles with the
+ * same set of low nibbles share one of 8 buckets, overflowing sets are
+ * merged into the last bucket (admitting false candidates, never missing).
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+build_start_set(struct TastyRegex *const restrict regex)
+{
+	uint32_t targets[UCHAR_MAX + 1];
+	uint16_t lows[16];
+	uint16_t bucket_lows[8];
+	const uint32_t *restrict row;
+	unsigned int token;
+	unsigned int cls;
+	unsigned int high;
+	unsigned int bucket;
+	unsigned int count_buckets;
+
+	const uint32_t initial = regex->initial;
+	const uint32_t span    = regex->span;
+
+	/* target of initial row per class */
+	row = &regex->states[initial & TASTY_STATE_OFFSET];
+
+	if (initial & TASTY_STATE_SPARSE) {
+		(void) memset(&targets[0],
+			      0,
+			      sizeof(uint32_t) * span);
+
+		for (cls = 0u; cls < row[0]; ++cls)
+			targets[row[1u + cls]] = row[1u + row[0] + cls];
+	} else {
+		(void) memcpy(&targets[0],
+			      row,
+			      sizeof(uint32_t) * span);
+	}
+
+	/* bytes outside the pattern ('other' class, last) begin matches: no
+	 * point in filtering */
+	regex->has_start_set = (targets[span - 1u] == 0u);
+
+	if (!regex->has_start_set)
+		return;
+
+	/* low nibbles starting a match per high nibble */
+	(void) memset(&lows[0],
+		      0,
+		      sizeof(lows));
+
+	for (token = 0u; token <= UCHAR_MAX; ++token)
+		if (targets[regex->classes[token]] != 0u)
+			lows[token >> 4] |= (uint16_t) (1u << (token & 0xfu));
+
+	(void) memset(&regex->start_low[0],
+		      0,
+		      sizeof(regex->start_low));
+
+	(void) memset(&regex->start_high[0],
+		      0,
+		      sizeof(regex->start_high));
+
+	count_buckets = 0u;
+
+	for (high = 0u; high < 16u; ++high) {
+		if (lows[high] == 0u)
+			continue;
+
+		for (bucket = 0u; bucket < count_buckets; ++bucket)
+			if (bucket_lows[bucket] == lows[high])
+				break;
+
+		if (bucket == count_buckets) {
+			if (count_buckets < 8u) {
+				bucket_lows[bucket] = lows[high];
+				++count_buckets;
+			} else {
+				bucket		     = 7u;
+				bucket_lows[bucket] |= lows[high];
+			}
+		}
+
+		regex->start_high[high] |= (unsigned char) (1u << bucket);
+	}
+
+	for (bucket = 0u; bucket < count_buckets; ++bucket)
+		for (token = 0u; token < 16u; ++token)
+			if (bucket_lows[bucket] & (1u << token))
+				regex->start_low[token]
+				|= (unsigned char) (1u << bucket);
+}
+
+
+/* lower DFA into a position-independent table of 32-bit row offsets
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline size_t
+row_fanout(const union TastyState *restrict state_from,
+	   const size_t span)
+{
+	size_t fanout;
+
+	const union TastyState *const restrict state_until = state_from + span;
+
+	fanout = 0l;
+
+	/* count explicit matches ('skip' in first cell not included) */
+	while (1) {
+		++state_from;
+		if (state_from == state_until)
+			return fanout;
+
+		fanout += (state_from->step != NULL_POINTER);
+	}
+}
+
+static inline bool
+row_is_sparse(const size_t fanout,
+	      const size_t span)
+{
+	return (fanout <= TASTY_SPARSE_FANOUT_MAX)
+	    && ((1l + (2l * fanout)) < span);
+}
+
+static inline uint32_t
+row_offset(const uint32_t *const restrict row_offsets,
+	   const union TastyState *const restrict state,
+	   const union TastyState *const restrict state_base,
+	   const size_t span)
+{
+	return (state == NULL_POINTER)
+	     ? 0u
+	     : row_offsets[(state - state_base) / span];
+}
+
+static inline int
+build_state_table(struct TastyRegex *const restrict regex,
+		  const union TastyState *const restrict initial,
+		  union TastyState *const restrict state_base,
+		  const union TastyState *const restrict state_until,
+		  const unsigned int flags)
+{
+	struct TastyRowGraph graph;
+	const union TastyState *restrict state;
+	const union TastyState *restrict state_from;
+	uint32_t *restrict cell;
+	uint32_t *restrict sparse_targets;
+	size_t *restrict stack_top;
+	size_t length_table;
+	size_t fanout;
+	size_t row;
+	size_t next_row;
+	int status;
+
+	const size_t span	= regex->span;
+	const size_t node_span	= NODE_SPAN(regex);
+	const size_t count_rows = (state_until - state_base) / node_span;
+	const size_t initial_row = (initial - state_base) / node_span;
+
+	/* route stack, offsets of state rows followed by offset of matching
+	 * row, leaders of state rows and matching row, state marks */
+	size_t *const restrict stack
+	= malloc((sizeof(size_t)   * count_rows)
+		 + (sizeof(uint32_t) * (count_rows + 1l) * 2l)
+		 + (sizeof(unsigned char) * (count_rows + 1l)));
+
+	if (UNLIKELY(stack == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	uint32_t *const restrict row_offsets
+	= (uint32_t *) (stack + count_rows);
+
+	uint32_t *const restrict leaders
+	= row_offsets + count_rows + 1l;
+
+	unsigned char *const restrict marks
+	= (unsigned char *) (leaders + count_rows + 1l);
+
+	(void) memset(row_offsets,
+		      0,
+		      sizeof(uint32_t) * (count_rows + 1l));
+
+	(void) memset(marks,
+		      0,
+		      sizeof(unsigned char) * (count_rows + 1l));
+
+	flatten_skips(marks,
+		      stack,
+		      state_base,
+		      state_until,
+		      node_span);
+
+	if (   (flags & TASTY_COMPILE_MINIMIZE)
+	    && (count_rows <= TASTY_MINIMIZE_STATE_LIMIT)) {
+		status = minimize_states(leaders,
+					 marks,
+					 state_base,
+					 state_until,
+					 node_span);
+		if (status != 0) {
+			free(stack);
+			return status;
+		}
+
+		/* only lay out leaders reachable from initial */
+		marks[initial_row] |= TASTY_MARK_REACHABLE;
+		stack_top	    = stack;
+		*stack_top	    = initial_row;
+		++stack_top;
+
+		do {
+			--stack_top;
+			state = state_base + (*stack_top * node_span);
+
+			for (state_from = state + 1l;
+			     state_from < state + node_span;
+			     ++state_from) {
+				if (state_from->step == NULL_POINTER)
+					continue;
+
+				next_row = leaders[state_index(state_from->step,
+							       state_base,
+							       state_until,
+							       node_span)];
+
+				if (marks[next_row] & TASTY_MARK_REACHABLE)
+					continue;
+
+				marks[next_row] |= TASTY_MARK_REACHABLE;
+
+				/* matching has no cells to follow */
+				if (next_row < count_rows) {
+					*stack_top = next_row;
+					++stack_top;
+				}
+			}
+		} while (stack_top > stack);
+
+	} else {
+		/* every row leads itself */
+		for (row = 0l; row <= count_rows; ++row) {
+			leaders[row] = (uint32_t) row;
+			marks[row]  |= TASTY_MARK_REACHABLE;
+		}
+	}
+
+	/* lay out leading rows, offset 0 is reserved for dead end */
+	length_table = 1l;
+
+	for (row = 0l; row < count_rows; ++row) {
+		if (   (leaders[row] != row)
+		    || !(marks[row] & TASTY_MARK_REACHABLE))
+			continue;
+
+		fanout = row_fanout(state_base + (row * node_span),
+				    node_span);
+
+		row_offsets[row] = (uint32_t) length_table;
+
+		if (marks[row] & TASTY_MARK_ACCEPTING)
+			row_offsets[row] |= TASTY_STATE_ACCEPTING;
+
+		if (row_is_sparse(fanout,
+				  span)) {
+			row_offsets[row] |= TASTY_STATE_SPARSE;
+			length_table	 += 1l + (2l * fanout);
+		} else {
+			length_table	 += span;
+		}
+	}
+
+	/* matching row has no explicit matches */
+	if (   (leaders[count_rows] == count_rows)
+	    && (marks[count_rows] & TASTY_MARK_REACHABLE)) {
+		row_offsets[count_rows] = ((uint32_t) length_table)
+					| TASTY_STATE_SPARSE
+					| TASTY_STATE_ACCEPTING;
+		length_table += 1l;
+	}
+
+	/* other rows share offset of their leader (leaders come first) */
+	for (row = 0l; row <= count_rows; ++row)
+		if (leaders[row] != row)
+			row_offsets[row] = row_offsets[leaders[row]];
+
+	if (UNLIKELY(length_table > TASTY_STATE_OFFSET)) {
+		free(stack);
+		return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	uint32_t *const restrict states = malloc(sizeof(uint32_t)
+						 * length_table);
+
+	if (UNLIKELY(states == NULL_POINTER)) {
+		free(stack);
+		return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	/* fill rows */
+	states[0] = 0u;
+	cell	  = states + 1l;
+
+	for (row = 0l; row < count_rows; ++row) {
+		if (   (leaders[row] != row)
+		    || !(marks[row] & TASTY_MARK_REACHABLE))
+			continue;
+
+		state  = state_base + (row * node_span);
+		fanout = row_fanout(state,
+				    node_span);
+
+		/* sparse: fanout, classes, targets */
+		if (row_is_sparse(fanout,
+				  span)) {
+			*cell = (uint32_t) fanout;
+			++cell;
+
+			sparse_targets = cell + fanout;
+
+			for (state_from = state + 1l;
+			     state_from < state + node_span;
+			     ++state_from) {
+				if (state_from->step == NULL_POINTER)
+					continue;
+
+				*cell = (uint32_t) (state_from - state - 1l);
+				++cell;
+
+				*sparse_targets = row_offset(row_offsets,
+							     state_from->step,
+							     state_base,
+							     node_span);
+				++sparse_targets;
+			}
+
+			cell = sparse_targets;
+
+		/* dense: target per class */
+		} else {
+			for (state_from = state + 1l;
+			     state_from < state + node_span;
+			     ++state_from) {
+				*cell = row_offset(row_offsets,
+						   state_from->step,
+						   state_base,
+						   node_span);
+				++cell;
+			}
+		}
+	}
+
+	/* matching: no explicit matches */
+	if (cell < (states + length_table))
+		*cell = 0u;
+
+	regex->states  = states;
+	regex->initial = row_offsets[initial_row];
+	regex->length_states = (uint32_t) length_table;
+
+	free(stack);
+
+	build_start_set(regex);
+
+	regex->row_steps      = NULL_POINTER;
+	regex->row_preds      = NULL_POINTER;
+	regex->rows_closing   = NULL_POINTER;
+	regex->count_set_rows = 0u;
+
+	if (length_table > TASTY_LITERAL_TABLE_LIMIT) {
+		extract_literals(regex,
+				 NULL_POINTER);
+		return 0;
+	}
+
+	status = row_graph_init(&graph,
+				regex,
+				length_table);
+
+	if (status == 0) {
+		extract_literals(regex,
+				 &graph);
+
+		status = build_row_set(regex,
+				       &graph);
+
+		row_graph_free(&graph);
+	}
+
+	if (status != 0)
+		free(states);
+
+	return status;
+}
+
+
+/* refine byte classes told apart by sizing pre-pass so that every byte of
+ * 'members' shares no class with a non-member
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+split_byte_classes(struct TastyPatternSize *const restrict size,
+		   const uint64_t *const restrict members)
+{
+	unsigned int hits[UCHAR_MAX + 1];
+	unsigned char split[UCHAR_MAX + 1];
+	unsigned int token;
+	unsigned int label;
+
+	const unsigned int count_labels = size->count_labels;
+
+	(void) memset(&hits[0],
+		      0,
+		      sizeof(unsigned int) * count_labels);
+
+	for (token = 0u; token <= UCHAR_MAX; ++token)
+		if (byte_set_has(members,
+				 token))
+			++hits[size->labels[token]];
+
+	/* members of a partly covered class move to a class of their own */
+	for (label = 0u; label < count_labels; ++label) {
+		split[label] = (unsigned char) label;
+
+		if ((hits[label] == 0u) || (hits[label] == size->label_sizes[label]))
+			continue;
+
+		split[label] = (unsigned char) size->count_labels;
+
+		size->label_sizes[label]		   -= hits[label];
+		size->label_sizes[size->count_labels]  = hits[label];
+		++(size->count_labels);
+	}
+
+	for (token = 0u; token <= UCHAR_MAX; ++token)
+		if (byte_set_has(members,
+				 token))
+			size->labels[token] = split[size->labels[token]];
+}
+
+static inline void
+split_byte_class(struct TastyPatternSize *const restrict size,
+		 const unsigned int byte)
+{
+	const unsigned int label = size->labels[byte];
+
+	if (size->label_sizes[label] == 1u)
+		return; /* already alone */
+
+	--(size->label_sizes[label]);
+
+	size->labels[byte]		      = (unsigned char) size->count_labels;
+	size->label_sizes[size->count_labels] = 1u;
+	++(size->count_labels);
+}
+
+/* refine byte classes so that ASCII letter 'byte' shares a class only with
+ * its other case */
+static inline void
+split_letter_class(struct TastyPatternSize *const restrict size,
+		   const unsigned int byte)
+{
+	uint64_t members[TASTY_BYTE_SET_WORDS];
+
+	(void) memset(&members[0],
+		      0,
+		      sizeof(members));
+
+	byte_set_add(&members[0],
+		     byte);
+	byte_set_add(&members[0],
+		     ascii_other_case(byte));
+
+	split_byte_classes(size,
+			   &members[0]);
+}
+
+/* tally rows and patches of wildcard or bracket state (or of 'count_rows'
+ * UTF8 automaton rows, 'count_close_rows' of which complete characters),
+ * check for operator */
+static inline const unsigned char *
+size_wild(struct TastyPatternSize *const restrict size,
+	  const unsigned char *restrict pattern,
+	  const size_t count_rows,
+	  const size_t count_close_rows)
+{
+	size->count_states += count_rows;
+
+	switch (*pattern) {
+	case '*':
+		++(size->count_patches);
+		return pattern + 1l;
+
+	case '+':
+		++(size->count_states);
+		++(size->count_patches);
+		return pattern + 1l;
+
+	case '?':
+		++(size->count_patches);
+		size->count_wild_patches += count_close_rows;
+		return pattern + 1l;
+
+	default:
+		size->count_wild_patches += count_close_rows;
+		return pattern;
+	}
+}
+
+/* tally rows of UTF8 automaton row 'node' of 'set' and those below it
+ * ('tails' noting the shared tails stepped into), refining byte classes so
+ * that every row steps alike on all bytes of a class */
+static void
+size_utf8_node(struct TastyPatternSize *const restrict size,
+	       size_t *const restrict count_rows,
+	       size_t *const restrict count_close_rows,
+	       bool *const restrict tails,
+	       const struct TastyCharSet *const restrict set,
+	       const struct TastyUtf8Node *const restrict node)
+{
+	uint64_t members[TASTY_BYTE_SET_WORDS];
+	unsigned char steps[UCHAR_MAX + 1];
+	struct TastyUtf8Node child;
+	unsigned int byte;
+	unsigned int step;
+	bool stepped;
+
+	utf8_node_steps(&steps[0],
+			set,
+			node);
+
+	++(*count_rows);
+
+	for (step = 1u; step <= TASTY_UTF8_STEP_CLOSE; ++step) {
+		(void) memset(&members[0],
+			      0,
+			      sizeof(members));
+
+		stepped = false;
+
+		for (byte = 0u; byte <= UCHAR_MAX; ++byte)
+			if (steps[byte] == step) {
+				byte_set_add(&members[0],
+					     byte);
+				stepped = true;
+			}
+
+		if (!stepped)
+			continue;
+
+		split_byte_classes(size,
+				   &members[0]);
+
+		if (step == TASTY_UTF8_STEP_CLOSE)
+			++(*count_close_rows);
+		else
+			tails[step] = true;
+	}
+
+	for (byte = 0u; byte <= UCHAR_MAX; ++byte)
+		if (steps[byte] == TASTY_UTF8_STEP_NODE) {
+			split_byte_class(size,
+					 byte);
+
+			utf8_child_node(&child,
+					node,
+					byte);
+
+			size_utf8_node(size,
+				       count_rows,
+				       count_close_rows,
+				       tails,
+				       set,
+				       &child);
+		}
+}
+
+/* tally rows and patches of UTF8 automaton of 'set', check for operator */
+static inline const unsigned char *
+size_utf8_set(struct TastyPatternSize *const restrict size,
+	      const unsigned char *restrict pattern,
+	      const struct TastyCharSet *const restrict set)
+{
+	uint64_t continuation[TASTY_BYTE_SET_WORDS];
+	bool tails[TASTY_UTF8_STEP_CLOSE];
+	size_t count_rows;
+	size_t count_close_rows;
+	unsigned int width;
+	unsigned int byte;
+
+	const struct TastyUtf8Node root = {
+		.base  = 0u,
+		.width = 0u,
+		.first = 0u,
+		.last  = 0u
+	};
+
+	count_rows	 = 0l;
+	count_close_rows = 0l;
+
+	(void) memset(&tails[0],
+		      0,
+		      sizeof(tails));
+
+	size_utf8_node(size,
+		       &count_rows,
+		       &count_close_rows,
+		       &tails[0],
+		       set,
+		       &root);
+
+	/* a tail steps on any continuation byte into the next shorter tail */
+	for (width = TASTY_UTF8_STEP_CLOSE - 1u; width > 1u; --width)
+		tails[width - 1u] |= tails[width];
+
+	if (tails[1]) {
+		(void) memset(&continuation[0],
+			      0,
+			      sizeof(continuation));
+
+		for (byte = 0x80u; byte <= 0xbfu; ++byte)
+			byte_set_add(&continuation[0],
+				     byte);
+
+		split_byte_classes(size,
+				   &continuation[0]);
+
+		++count_close_rows;
+
+		for (width = 1u; width < TASTY_UTF8_STEP_CLOSE; ++width)
+			count_rows += tails[width];
+	}
+
+	return size_wild(size,
+			 pattern,
+			 count_rows,
+			 count_close_rows);
+}
+
+/* tally copies of operand, sized by counts past those 'before' it, repeated
+ * '{min,max}' times: an unbounded copy loops, optional copies each pop a
+ * patch skipping to the end of the repetition */
+static inline bool
+size_repetition(struct TastyPatternSize *const restrict size,
+		const struct TastyPatternSize *const restrict before,
+		const unsigned int min,
+		const unsigned int max)
+{
+	const bool unbounded	   = (max == TASTY_REPEAT_UNBOUNDED);
+	const size_t extra_copies  = (unbounded ? min : (max - 1u));
+	const size_t count_skips   = (unbounded ? 0u  : (max - min));
+
+	size->count_states += (size->count_states - before->count_states)
+			    * extra_copies;
+
+	size->count_patches += ((size->count_patches - before->count_patches)
+				* extra_copies)
+			     + count_skips;
+
+	size->count_wild_patches += (size->count_wild_patches
+				     - before->count_wild_patches)
+				  * extra_copies;
+
+	if (size->count_states > TASTY_STATE_CELL_BUDGET) {
+		size->over_budget = true;
+		return false;
+	}
+
+	return true;
+}
+
+/* sizing pre-pass over chunk up to and past its closing ')' (or to end of
+ * pattern), returning NULL to stop early (and let parser report any error) */
+static const unsigned char *
+size_chunk(struct TastyPatternSize *const restrict size,
+	   const unsigned char *restrict pattern,
+	   const unsigned int flags)
+{
+	struct TastyPatternSize before;
+	struct TastyCharSet set;
+	uint64_t members[TASTY_BYTE_SET_WORDS];
+	unsigned char fold[2];
+	const unsigned char *restrict operand;
+	const unsigned char *restrict end;
+	unsigned int width;
+	unsigned int token;
+	unsigned int min;
+	unsigned int max;
+	size_t fold_patches;
+	bool negated;
+
+	const bool ignore_case = (flags & TASTY_COMPILE_IGNORE_CASE);
+	const bool utf8	       = (flags & TASTY_COMPILE_UTF8);
+
+	operand = pattern;
+
+	while (1) {
+		/* repeat operand preceding '{min,max}' */
+		if (*pattern == '{') {
+			end = parse_repetition(&min,
+					       &max,
+					       pattern);
+
+			if (end != NULL_POINTER) {
+				if (   !operand_repeatable(operand,
+							   pattern)
+				    || !repetition_valid(min,
+							 max)
+				    || !size_repetition(size,
+							&before,
+							min,
+							max))
+					return NULL_POINTER;
+
+				pattern = end;
+				operand = end;
+				continue;
+			}
+		}
+
+		before.count_states	  = size->count_states;
+		before.count_patches	  = size->count_patches;
+		before.count_wild_patches = size->count_wild_patches;
+		operand			  = pattern;
+
+		switch (*pattern) {
+		case '\0':
+			return pattern;
+
+		case ')':
+			return pattern + 1l;
+
+		case '|':
+		case '*': /* no operand, let parser report */
+		case '+':
+		case '?':
+			++pattern;
+			continue;
+
+		case '(':
+			pattern = size_chunk(size,
+					     pattern + 1l,
+					     flags);
+
+			if (pattern == NULL_POINTER)
+				return NULL_POINTER;
+
+			switch (*pattern) {
+			case '+': /* loop state appended to sub chunk */
+				++(size->count_states);
+				++pattern;
+				continue;
+
+			case '?': /* skip over sub chunk */
+				++(size->count_patches);
+				/* fall through */
+			case '*':
+				++pattern;
+				/* fall through */
+			default:
+				continue;
+			}
+
+		case '.':
+			if (utf8) {
+				set.members	= NULL_POINTER;
+				set.negated	= true;
+				set.ignore_case = false;
+
+				pattern = size_utf8_set(size,
+							pattern + 1l,
+							&set);
+				continue;
+			}
+
+			pattern = size_wild(size,
+					    pattern + 1l,
+					    1l,
+					    1l);
+			continue;
+
+		case '[':
+			set.members = pattern + 1l + (pattern[1] == '^');
+
+			pattern = parse_bracket(&members[0],
+						&negated,
+						pattern + 1l,
+						utf8);
+
+			if (pattern == NULL_POINTER)
+				return NULL_POINTER; /* invalid bracket */
+
+			if (utf8) {
+				set.negated	= negated;
+				set.ignore_case = ignore_case;
+
+				pattern = size_utf8_set(size,
+							pattern,
+							&set);
+				continue;
+			}
+
+			/* negation keeps same classes */
+			if (ignore_case)
+				for (token = 'A'; token <= 'Z'; ++token)
+					if (   byte_set_has(&members[0],
+							    token)
+					    || byte_set_has(&members[0],
+							    token | 0x20u)) {
+						byte_set_add(&members[0],
+							     token);
+						byte_set_add(&members[0],
+							     token | 0x20u);
+					}
+
+			split_byte_classes(size,
+					   &members[0]);
+
+			pattern = size_wild(size,
+					    pattern,
+					    1l,
+					    1l);
+			continue;
+
+		case '$': /* anchors end if last, else literal */
+			if (pattern[1] == '\0') {
+				size->anchor_end = true;
+				return pattern + 1l;
+			}
+
+			width = 1u;
+			break;
+
+		case '\\':
+			++pattern;
+			if (*pattern == '\0')
+				return NULL_POINTER; /* invalid escape */
+
+			width = 1u;
+			break;
+
+		default:
+			width = utf8_head_width(*pattern);
+			if (width == 0u)
+				return NULL_POINTER; /* invalid UTF8 */
+		}
+
+		/* one state per byte of literal */
+		size->count_states += width;
+		fold_patches	    = 0l;
+
+		/* two-byte letter steps on either case into a second tail state
+		 * (unless lead bytes agree), leaving a second loose end */
+		if (   ignore_case
+		    && (width == 2u)
+		    && ((pattern[1] & 0xc0u) == 0x80u)
+		    && utf8_fold_pair(pattern,
+				      &fold[0])) {
+			size->count_states += (fold[0] != pattern[0]);
+			fold_patches	    = 1l;
+
+			split_byte_class(size,
+					 fold[0]);
+			split_byte_class(size,
+					 fold[1]);
+		}
+
+		do {
+			if (*pattern == '\0')
+				return NULL_POINTER; /* invalid UTF8 */
+
+			if (ignore_case && (ascii_other_case(*pattern) != *pattern))
+				split_letter_class(size,
+						   *pattern);
+			else
+				split_byte_class(size,
+						 *pattern);
+			++pattern;
+			--width;
+		} while (width > 0u);
+
+		switch (*pattern) {
+		case '+':
+			++(size->count_states);
+			++(size->count_patches);
+			++pattern;
+			continue;
+
+		case '?':
+			size->count_patches += 2l + fold_patches;
+			++pattern;
+			continue;
+
+		case '*':
+			++(size->count_patches);
+			++pattern;
+			continue;
+
+		default:
+			size->count_patches += 1l + fold_patches;
+			continue;
+		}
+	}
+}
+
+/* sizing pre-pass: tell apart every byte matched explicitly and tally the
+ * number of state rows and patch nodes the parse will pop (exact, save for
+ * brackets and rows of UTF8 automata completing characters, which are sized
+ * as wildcards).  With TASTY_COMPILE_IGNORE_CASE, both cases of a letter are
+ * matched explicitly: ASCII letters share a class with their other case,
+ * two-byte letters add the bytes of their other case.  With
+ * TASTY_COMPILE_UTF8, '.' and brackets split off the bytes each of their
+ * automaton rows steps on alike.
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+size_pattern(struct TastyPatternSize *const restrict size,
+	     const unsigned char *restrict pattern,
+	     const unsigned int flags)
+{
+	size->count_states	 = 0l;
+	size->count_patches	 = 0l;
+	size->count_wild_patches = 0l;
+	size->anchor_end	 = false;
+	size->over_budget	 = false;
+
+	/* all bytes start out in a single class */
+	size->count_labels   = 1u;
+	size->label_sizes[0] = UCHAR_MAX + 1;
+
+	(void) memset(&size->labels[0],
+		      0,
+		      sizeof(size->labels));
+
+	/* size past any unbalanced ')', let parser report */
+	do {
+		pattern = size_chunk(size,
+				     pattern,
+				     flags);
+	} while ((pattern != NULL_POINTER) && (*pattern != '\0'));
+}
+
+
+/* number byte classes told apart by sizing pre-pass (bytes never named
+ * explicitly in pattern, including '\0', cannot be told apart and share the
+ * final class)
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+init_byte_classes(struct TastyRegex *const restrict regex,
+		  const struct TastyPatternSize *const restrict size)
+{
+	unsigned int class_of[UCHAR_MAX + 1];
+	unsigned char *restrict classes;
+	unsigned int token;
+	unsigned int label;
+	unsigned int next_class;
+
+	const unsigned int label_other = size->labels[0];
+
+	classes	   = &regex->classes[0];
+	next_class = 0u;
+
+	for (label = 0u; label < size->count_labels; ++label)
+		class_of[label] = UINT_MAX;
+
+	/* number classes in order of their least byte */
+	for (token = 1u; token <= UCHAR_MAX; ++token) {
+		label = size->labels[token];
+
+		if ((label != label_other) && (class_of[label] == UINT_MAX)) {
+			class_of[label] = next_class;
+			++next_class;
+		}
+	}
+
+	class_of[label_other] = next_class;
+
+	for (token = 0u; token <= UCHAR_MAX; ++token)
+		classes[token] = (unsigned char) class_of[size->labels[token]];
+
+	regex->span = next_class + 1u;
+}
+
+
+/* fetch two-byte letter matching either case: 'state_first' steps on either
+ * lead byte into a tail state (shared if lead bytes agree), which steps on
+ * the matching tail byte
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+fetch_folded_state(union TastyState *const restrict state_first,
+		   union TastyState *restrict *const restrict state_alloc,
+		   struct TastyPatch *restrict *const restrict patch_alloc,
+		   struct TastyPatch *restrict *const restrict patch_head,
+		   const unsigned char *restrict *const restrict pattern_ptr,
+		   const unsigned char *const restrict classes,
+		   const size_t span,
+		   const unsigned char *const restrict fold)
+{
+	const unsigned char *restrict pattern = *pattern_ptr;
+
+	const unsigned int token_first1 = classes[pattern[0]] + 1u;
+	const unsigned int token_last1	= classes[pattern[1]] + 1u;
+	const unsigned int token_first2 = classes[fold[0]] + 1u;
+	const unsigned int token_last2	= classes[fold[1]] + 1u;
+
+	union TastyState *const restrict state_last1 = state_first + span;
+	union TastyState *const restrict state_last2
+	= (fold[0] == pattern[0])
+	? state_last1
+	: (state_last1 + span);
+
+	union TastyState *const restrict state_next = state_last2 + span;
+
+	state_first[token_first1].step = state_last1;
+	state_first[token_first2].step = state_last2;
+
+	pattern += 2l;
+
+	switch (*pattern) {
+	case '*':
+		*pattern_ptr = pattern + 1l;
+		*state_alloc = state_next; /* pop state nodes */
+		fold_wide_zero_or_more(state_first,
+				       state_last1,
+				       state_last2,
+				       patch_alloc,
+				       patch_head,
+				       token_last1,
+				       token_last2);
+		return;
+
+	case '+':
+		*pattern_ptr = pattern + 1l;
+		*state_alloc = state_next + span; /* pop state nodes */
+		fold_wide_one_or_more(state_last1,
+				      state_last2,
+				      state_next,
+				      patch_alloc,
+				      patch_head,
+				      token_first1,
+				      token_first2,
+				      token_last1,
+				      token_last2);
+		return;
+
+	case '?':
+		*pattern_ptr = pattern + 1l;
+		*state_alloc = state_next; /* pop state nodes */
+		fold_wide_zero_or_one(state_first,
+				      state_last1,
+				      state_last2,
+				      patch_alloc,
+				      patch_head,
+				      token_last1,
+				      token_last2);
+		return;
+
+	default:
+		*pattern_ptr = pattern;
+		*state_alloc = state_next; /* pop state nodes */
+		fold_wide_one(state_last1,
+			      state_last2,
+			      patch_alloc,
+			      patch_head,
+			      token_last1,
+			      token_last2);
+		return;
+	}
+}
+
+
+/* fetch UTF8 automaton of a character set: the root row steps on lead bytes
+ * into rows of their own (on each partly matched range of continuation
+ * bytes) or into tails shared by all rows (on fully matched ranges), and the
+ * final continuation (or ASCII) bytes complete a character by stepping into
+ * 'state_close' (or leaving loose ends if NULL)
+ * ────────────────────────────────────────────────────────────────────────── */
+static union TastyState *
+fetch_utf8_tail(union TastyState *restrict *const restrict tails,
+		union TastyState *restrict *const restrict state_alloc,
+		struct TastyPatch *restrict *const restrict patch_alloc,
+		struct TastyPatch *restrict *const restrict patch_head,
+		const unsigned char *const restrict classes,
+		const size_t span,
+		union TastyState *const restrict state_close,
+		const unsigned int width)
+{
+	uint64_t class_set[TASTY_BYTE_SET_WORDS];
+	union TastyState *restrict state_next;
+	unsigned int byte;
+
+	union TastyState *restrict state = tails[width];
+
+	if (state != NULL_POINTER)
+		return state;
+
+	/* pop state node */
+	state	      = *state_alloc;
+	*state_alloc += span;
+	tails[width]  = state;
+
+	(void) memset(&class_set[0],
+		      0,
+		      sizeof(class_set));
+
+	for (byte = 0x80u; byte <= 0xbfu; ++byte)
+		byte_set_add(&class_set[0],
+			     classes[byte]);
+
+	if (width > 1u) {
+		state_next = fetch_utf8_tail(tails,
+					     state_alloc,
+					     patch_alloc,
+					     patch_head,
+					     classes,
+					     span,
+					     state_close,
+					     width - 1u);
+
+		join_set_state(state,
+			       state_next,
+			       span,
+			       &class_set[0]);
+
+	} else if (state_close == NULL_POINTER) {
+		push_set_patches(patch_head,
+				 patch_alloc,
+				 state,
+				 span,
+				 &class_set[0]);
+	} else {
+		join_set_state(state,
+			       state_close,
+			       span,
+			       &class_set[0]);
+	}
+
+	return state;
+}
+
+static void
+fetch_utf8_node(union TastyState *const restrict state,
+		union TastyState *restrict *const restrict tails,
+		union TastyState *restrict *const restrict state_alloc,
+		struct TastyPatch *restrict *const restrict patch_alloc,
+		struct TastyPatch *restrict *const restrict patch_head,
+		const struct TastyCharSet *const restrict set,
+		const struct TastyUtf8Node *const restrict node,
+		const unsigned char *const restrict classes,
+		const size_t span,
+		union TastyState *const state_close)
 {
-	/* pop patch node */
-	struct TastyPatch *const restrict patch = *patch_alloc;
-	++(*patch_alloc);
+	uint64_t class_set[TASTY_BYTE_SET_WORDS];
+	unsigned char steps[UCHAR_MAX + 1];
+	struct TastyUtf8Node child;
+	union TastyState *restrict state_next;
+	unsigned int byte;
 
-	/* record skip pointer needing to be set */
-	patch->state = &state_first->skip;
+	utf8_node_steps(&steps[0],
+			set,
+			node);
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+	(void) memset(&class_set[0],
+		      0,
+		      sizeof(class_set));
 
-	/* patch match with start of self */
-	state_last->step[token_last] = state_first;
-}
+	for (byte = 0u; byte <= UCHAR_MAX; ++byte)
+		switch (steps[byte]) {
+		case TASTY_UTF8_STEP_DEAD:
+			continue;
 
+		case TASTY_UTF8_STEP_CLOSE:
+			byte_set_add(&class_set[0],
+				     classes[byte]);
+			continue;
 
-static inline void
-match_one_or_more(union TastyState *const restrict state_one,
-		  union TastyState *const restrict state_zero_or_more,
-		  struct TastyPatch *restrict *const restrict patch_alloc,
-		  struct TastyPatch *restrict *const restrict patch_head,
-		  const unsigned char token)
-{
-	struct TastyPatch *restrict patch;
+		case TASTY_UTF8_STEP_NODE: /* byte has a class of its own */
+			utf8_child_node(&child,
+					node,
+					byte);
 
-	/* patch first match */
-	state_one->step[token] = state_zero_or_more;
+			/* pop state node */
+			state_next    = *state_alloc;
+			*state_alloc += span;
 
-	/* pop patch node */
-	 patch = *patch_alloc;
-	++(*patch_alloc);
+			state[classes[byte] + 1u].step = state_next;
 
-	/* record skip pointer needing to be set */
-	patch->state = &state_zero_or_more->skip;
+			fetch_utf8_node(state_next,
+					tails,
+					state_alloc,
+					patch_alloc,
+					patch_head,
+					set,
+					&child,
+					classes,
+					span,
+					state_close);
+			continue;
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+		default:
+			state[classes[byte] + 1u].step
+			= fetch_utf8_tail(tails,
+					  state_alloc,
+					  patch_alloc,
+					  patch_head,
+					  classes,
+					  span,
+					  state_close,
+					  steps[byte]);
+		}
 
-	/* patch second state with self on match */
-	state_zero_or_more->step[token] = state_zero_or_more;
+	if (state_close == NULL_POINTER)
+		push_set_patches(patch_head,
+				 patch_alloc,
+				 state,
+				 span,
+				 &class_set[0]);
+	else
+		join_set_state(state,
+			       state_close,
+			       span,
+			       &class_set[0]);
 }
 
 static inline void
-wild_one_or_more(union TastyState *const restrict state_one,
-		 union TastyState *const restrict state_zero_or_more,
-		 struct TastyPatch *restrict *const restrict patch_alloc,
-		 struct TastyPatch *restrict *const restrict patch_head)
+fetch_utf8_set(union TastyState *const restrict state_first,
+	       union TastyState *restrict *const restrict state_alloc,
+	       struct TastyPatch *restrict *const restrict patch_alloc,
+	       struct TastyPatch *restrict *const restrict patch_head,
+	       const unsigned char *restrict *const restrict pattern_ptr,
+	       const struct TastyCharSet *const restrict set,
+	       const unsigned char *const restrict classes,
+	       const size_t span)
 {
+	union TastyState *tails[TASTY_UTF8_STEP_CLOSE];
+	union TastyState *restrict state_close;
 	struct TastyPatch *restrict patch;
 
-	/* patch first match */
-	join_wild_state(state_one,
-			state_zero_or_more);
+	const unsigned char *const restrict pattern = *pattern_ptr;
 
-	/* pop patch node */
-	 patch = *patch_alloc;
-	++(*patch_alloc);
+	const struct TastyUtf8Node root = {
+		.base  = 0u,
+		.width = 0u,
+		.first = 0u,
+		.last  = 0u
+	};
 
-	/* record skip pointer needing to be set */
-	patch->state = &state_zero_or_more->skip;
+	(void) memset(&tails[0],
+		      0,
+		      sizeof(tails));
 
-	/* push patch into head of patch_list */
-	patch->next = *patch_head;
-	*patch_head = patch;
+	*state_alloc = state_first + span; /* pop root state node */
+	state_close  = NULL_POINTER;
 
-	/* patch second state with self on wild */
-	join_wild_state(state_zero_or_more,
-			state_zero_or_more);
-}
+	switch (*pattern) {
+	case '*': /* characters loop back to root */
+		state_close = state_first;
+		break;
 
-static inline void
-match_wide_one_or_more(union TastyState *const restrict state_second,
-		       union TastyState *const restrict state_last,
-		       union TastyState *const restrict state_zero_or_more,
-		       struct TastyPatch *restrict *const restrict patch_alloc,
-		       struct TastyPatch *restrict *const restrict patch_head,
-		       const unsigned char token_first,
-		       const unsigned char token_last)
-{
-	struct TastyPatch *restrict patch;
+	case '+': /* characters step into a looping copy of root */
+		state_close   = *state_alloc;
+		*state_alloc += span; /* pop state node */
+		break;
 
-	/* patch first match */
-	state_last->step[token_last] = state_zero_or_more;
+	case '?':
+		break;
+
+	default:
+		*pattern_ptr = pattern;
+		fetch_utf8_node(state_first,
+				&tails[0],
+				state_alloc,
+				patch_alloc,
+				patch_head,
+				set,
+				&root,
+				classes,
+				span,
+				NULL_POINTER);
+		return;
+	}
+
+	*pattern_ptr = pattern + 1l;
 
 	/* pop patch node */
-	 patch = *patch_alloc;
+	patch = *patch_alloc;
 	++(*patch_alloc);
 
 	/* record skip pointer needing to be set */
-	patch->state = &state_zero_or_more->skip;
+	patch->state = (state_close == NULL_POINTER)
+		     ? &state_first->skip
+		     : &state_close->skip;
 
 	/* push patch into head of patch_list */
 	patch->next = *patch_head;
 	*patch_head = patch;
 
-	/* patch looping state with second in chain */
-	state_zero_or_more->step[token_first] = state_second;
+	fetch_utf8_node(state_first,
+			&tails[0],
+			state_alloc,
+			patch_alloc,
+			patch_head,
+			set,
+			&root,
+			classes,
+			span,
+			state_close);
+
+	if ((state_close != NULL_POINTER) && (state_close != state_first))
+		(void) memcpy(state_close + 1l,
+			      state_first + 1l,
+			      sizeof(union TastyState) * (span - 1l));
 }
 
 
-
-/* fetch next state node from pattern
+/* fetch next state node from pattern (or chain of nodes, for a multibyte
+ * literal), including any '?', '*' or '+' operator
  * ────────────────────────────────────────────────────────────────────────── */
 static inline int
-fetch_next_state(union TastyState *restrict *const restrict state,
+fetch_next_atom(union TastyState *restrict *const restrict state,
 		 union TastyState *restrict *const restrict state_alloc,
 		 struct TastyPatch *restrict *const restrict patch_alloc,
 		 struct TastyPatch *restrict *const restrict patch_head,
-		 const unsigned char *restrict *const restrict pattern_ptr)
+		 const unsigned char *restrict *const restrict pattern_ptr,
+		 const struct TastyRegex *const restrict regex)
 {
 	static const bool valid_escape_map[UCHAR_MAX + 1] = {
 		['\\'] = true,
@@ -624,45 +4157,85 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 		['(']  = true,
 		[')']  = true,
 		['?']  = true,
-		['|']  = true
+		['|']  = true,
+		['^']  = true,
+		['$']  = true,
+		['[']  = true,
+		[']']  = true,
+		['{']  = true,
+		['}']  = true
 	};
 
+	struct TastyCharSet set;
+	uint64_t members[TASTY_BYTE_SET_WORDS];
+	uint64_t class_set[TASTY_BYTE_SET_WORDS];
+	unsigned char fold[2];
 	const unsigned char *restrict pattern;
-	unsigned char token;
+	unsigned int token;
+	unsigned int min;
+	unsigned int max;
+	bool negated;
 	union TastyState *restrict state_prev;
 	union TastyState *restrict state_next;
 
+	const unsigned char *const restrict classes = &regex->classes[0];
+	const size_t span			    = NODE_SPAN(regex);
+
 	union TastyState *const restrict state_first = *state_alloc;
 	*state	   = state_first;
 	state_prev = state_first;
-	state_next = state_prev + 1l;
+	state_next = state_prev + span;
 
 	pattern = *pattern_ptr;
 	token   = *pattern;
 
-	switch (utf8_head_width(token)) {
+	const unsigned int width = utf8_head_width(token);
+
+	/* ensure multibyte sequence is complete before popping states */
+	if (   (width > 1u)
+	    && !utf8_tail_valid(pattern + 1l,
+				width - 1u))
+		return TASTY_ERROR_INVALID_UTF8;
+
+	/* two-byte letter matches either case */
+	if (   (width == 2u)
+	    && (regex->flags & TASTY_COMPILE_IGNORE_CASE)
+	    && utf8_fold_pair(pattern,
+			      &fold[0])) {
+		fetch_folded_state(state_first,
+				   state_alloc,
+				   patch_alloc,
+				   patch_head,
+				   pattern_ptr,
+				   classes,
+				   span,
+				   &fold[0]);
+		return 0;
+	}
+
+	switch (width) {
 	case 4u:
-		state_prev->step[token] = state_next;
+		state_prev[classes[token] + 1u].step = state_next;
 		state_prev = state_next;
-		++state_next;
+		state_next += span;
 		++pattern;
 		/* fall through */
 	case 3u:
-		state_prev->step[*pattern] = state_next;
+		state_prev[classes[*pattern] + 1u].step = state_next;
 		state_prev = state_next;
-		++state_next;
+		state_next += span;
 		++pattern;
 		/* fall through */
 	case 2u:
-		state_prev->step[*pattern] = state_next;
+		state_prev[classes[*pattern] + 1u].step = state_next;
 		++pattern;
-		const unsigned char token_last = *pattern;
+		const unsigned int token_last = classes[*pattern] + 1u;
 
 		++pattern;
 		switch (*pattern) {
 		case '*':
 			*pattern_ptr = pattern + 1l;
-			*state_alloc = state_next + 1l; /* pop state nodes */
+			*state_alloc = state_next + span; /* pop state nodes */
 			match_wide_zero_or_more(state_first,
 						state_next,
 						patch_alloc,
@@ -672,19 +4245,20 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 
 		case '+':
 			*pattern_ptr = pattern + 1l;
-			*state_alloc = state_next + 2l; /* pop state nodes */
-			match_wide_one_or_more(state_first + 1l,
+			/* pop state nodes */
+			*state_alloc = state_next + (2l * span);
+			match_wide_one_or_more(state_first + span,
 					       state_next,
-					       state_next + 1l,
+					       state_next + span,
 					       patch_alloc,
 					       patch_head,
-					       token,
+					       classes[token] + 1u,
 					       token_last);
 			return 0;
 
 		case '?':
 			*pattern_ptr = pattern + 1l;
-			*state_alloc = state_next + 1l; /* pop state nodes */
+			*state_alloc = state_next + span; /* pop state nodes */
 			match_wide_zero_or_one(state_first,
 					       state_next,
 					       patch_alloc,
@@ -694,7 +4268,7 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 
 		default:
 			*pattern_ptr = pattern;
-			*state_alloc = state_next + 1l; /* pop state nodes */
+			*state_alloc = state_next + span; /* pop state nodes */
 			match_wide_one(state_next,
 				       patch_alloc,
 				       patch_head,
@@ -709,6 +4283,19 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 	}
 
 
+	/* trailing '$' anchors end of pattern */
+	if (   (token == '$')
+	    && (pattern[1] == '\0')
+	    && (regex->anchors & TASTY_ANCHOR_END))
+		return TASTY_CONTROL_END_OF_PATTERN;
+
+	/* '{' opening a repetition follows no operand */
+	if (   (token == '{')
+	    && (parse_repetition(&min,
+				 &max,
+				 pattern) != NULL_POINTER))
+		return TASTY_ERROR_NO_OPERAND;
+
 	/* fetch token */
 	switch (token) {
 	case '\0': /* let caller handle control characters */
@@ -727,22 +4314,43 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 
 	case '.': /* wild state, check for operator */
 		++pattern;
+
+		if (regex->flags & TASTY_COMPILE_UTF8) {
+			set.members	= NULL_POINTER;
+			set.negated	= true;
+			set.ignore_case = false;
+
+			*pattern_ptr = pattern;
+			fetch_utf8_set(state_first,
+				       state_alloc,
+				       patch_alloc,
+				       patch_head,
+				       pattern_ptr,
+				       &set,
+				       classes,
+				       span);
+			return 0;
+		}
+
 		switch (*pattern) {
 		case '*':
 			*pattern_ptr = pattern + 1l;
 			*state_alloc = state_next; /* pop state node */
 			wild_zero_or_more(state_first,
 					  patch_alloc,
-					  patch_head);
+					  patch_head,
+					  span);
 			return 0;
 
 		case '+':
 			*pattern_ptr = pattern + 1l;
-			*state_alloc = state_next + 1l; /* pop 2 state nodes */
+			/* pop 2 state nodes */
+			*state_alloc = state_next + span;
 			wild_one_or_more(state_first,
 					 state_next,
 					 patch_alloc,
-					 patch_head);
+					 patch_head,
+					 span);
 			return 0;
 
 		case '?':
@@ -750,7 +4358,8 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 			*state_alloc = state_next; /* pop state node */
 			wild_zero_or_one(state_first,
 					 patch_alloc,
-					 patch_head);
+					 patch_head,
+					 span);
 			return 0;
 
 		default:
@@ -758,7 +4367,97 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 			*state_alloc = state_next; /* pop state node */
 			wild_one(state_first,
 				 patch_alloc,
-				 patch_head);
+				 patch_head,
+				 span);
+			return 0;
+		}
+
+
+	case '[': /* bracket state, check for operator */
+		set.members = pattern + 1l + (pattern[1] == '^');
+
+		pattern = parse_bracket(&members[0],
+					&negated,
+					pattern + 1l,
+					regex->flags & TASTY_COMPILE_UTF8);
+
+		if (pattern == NULL_POINTER)
+			return TASTY_ERROR_INVALID_BRACKET;
+
+		if (regex->flags & TASTY_COMPILE_UTF8) {
+			set.negated	= negated;
+			set.ignore_case = regex->flags & TASTY_COMPILE_IGNORE_CASE;
+
+			*pattern_ptr = pattern;
+			fetch_utf8_set(state_first,
+				       state_alloc,
+				       patch_alloc,
+				       patch_head,
+				       pattern_ptr,
+				       &set,
+				       classes,
+				       span);
+			return 0;
+		}
+
+		/* classes of members (members of either case share classes if
+		 * TASTY_COMPILE_IGNORE_CASE), or of all other bytes */
+		(void) memset(&class_set[0],
+			      0,
+			      sizeof(class_set));
+
+		for (token = 0u; token <= UCHAR_MAX; ++token)
+			if (byte_set_has(&members[0],
+					 token))
+				byte_set_add(&class_set[0],
+					     classes[token]);
+
+		if (negated)
+			for (token = 0u; token < regex->span; ++token)
+				class_set[token >> 6] ^= ((uint64_t) 1u)
+						      << (token & 63u);
+
+		switch (*pattern) {
+		case '*':
+			*pattern_ptr = pattern + 1l;
+			*state_alloc = state_next; /* pop state node */
+			set_zero_or_more(state_first,
+					 patch_alloc,
+					 patch_head,
+					 span,
+					 &class_set[0]);
+			return 0;
+
+		case '+':
+			*pattern_ptr = pattern + 1l;
+			/* pop 2 state nodes */
+			*state_alloc = state_next + span;
+			set_one_or_more(state_first,
+					state_next,
+					patch_alloc,
+					patch_head,
+					span,
+					&class_set[0]);
+			return 0;
+
+		case '?':
+			*pattern_ptr = pattern + 1l;
+			*state_alloc = state_next; /* pop state node */
+			set_zero_or_one(state_first,
+					patch_alloc,
+					patch_head,
+					span,
+					&class_set[0]);
+			return 0;
+
+		default:
+			*pattern_ptr = pattern;
+			*state_alloc = state_next; /* pop state node */
+			set_one(state_first,
+				patch_alloc,
+				patch_head,
+				span,
+				&class_set[0]);
 			return 0;
 		}
 
@@ -771,6 +4470,7 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 			return TASTY_ERROR_INVALID_ESCAPE;
 		/* fall through */
 	default: /* literal match state, check for operator */
+		token = classes[token] + 1u;
 		++pattern;
 		switch (*pattern) {
 		case '*':
@@ -784,7 +4484,8 @@ fetch_next_state(union TastyState *restrict *const restrict state,
 
 		case '+':
 			*pattern_ptr = pattern + 1l;
-			*state_alloc = state_next + 1l; /* pop 2 state nodes */
+			/* pop 2 state nodes */
+			*state_alloc = state_next + span;
 			match_one_or_more(state_first,
 					  state_next,
 					  patch_alloc,
@@ -818,11 +4519,225 @@ int
 fetch_next_sub_chunk(struct TastyChunk *const restrict chunk,
 		     union TastyState *restrict *const restrict state_alloc,
 		     struct TastyPatch *restrict *const restrict patch_alloc,
-		     const unsigned char *restrict *const restrict pattern_ptr)
+		     const unsigned char *restrict *const restrict pattern_ptr,
+		     const struct TastyRegex *const restrict regex);
+
+/* parse another copy of 'operand' into 'copy', either a sub chunk (following
+ * '(') or a single operand with no operator */
+static inline int
+fetch_copy(struct TastyChunk *const restrict copy,
+	   union TastyState *restrict *const restrict state_alloc,
+	   struct TastyPatch *restrict *const restrict patch_alloc,
+	   const unsigned char *restrict operand,
+	   const struct TastyRegex *const restrict regex,
+	   const bool is_sub_chunk)
+{
+	if (is_sub_chunk)
+		return fetch_next_sub_chunk(copy,
+					    state_alloc,
+					    patch_alloc,
+					    &operand,
+					    regex);
+
+	copy->patches.head    = NULL_POINTER;
+	copy->patches.end_ptr = &(*patch_alloc)->next;
+
+	return fetch_next_atom(&copy->start,
+			       state_alloc,
+			       patch_alloc,
+			       &copy->patches.head,
+			       &operand,
+			       regex);
+}
+
+/* repeat 'chunk', parsed from 'operand', '{min,max}' times: the operand is
+ * parsed again for each copy after the first, and copies are chained.
+ * Optional copies skip straight to the end of the repetition (sharing one
+ * tail rather than stepping through the skips of every following copy), and
+ * an unbounded repetition ends with a copy looping on itself, so 'X{2,5}'
+ * pops 5 copies of 'X' and 3 patches, and 'X{2,}' pops 3 copies.
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline int
+repeat_chunk(struct TastyChunk *const restrict chunk,
+	     union TastyState *restrict *const restrict state_alloc,
+	     struct TastyPatch *restrict *const restrict patch_alloc,
+	     const unsigned char *restrict *const restrict pattern_ptr,
+	     const unsigned char *const restrict operand,
+	     const struct TastyRegex *const restrict regex,
+	     const bool is_sub_chunk)
+{
+	struct TastyChunk copy;
+	struct TastyChunk *restrict current;
+	struct TastyPatchList skips;
+	struct TastyPatch *restrict patch;
+	unsigned int min;
+	unsigned int max;
+	unsigned int count_copies;
+	int status;
+
+	const unsigned char *const restrict end = parse_repetition(&min,
+								   &max,
+								   *pattern_ptr);
+
+	if (end == NULL_POINTER)
+		return 0; /* '{' matches itself */
+
+	if (!repetition_valid(min,
+			      max))
+		return TASTY_ERROR_INVALID_REPETITION;
+
+	*pattern_ptr = end;
+
+	const bool unbounded = (max == TASTY_REPEAT_UNBOUNDED);
+	const unsigned int total_copies = unbounded ? (min + 1u) : max;
+
+	skips.head    = NULL_POINTER;
+	skips.end_ptr = &skips.head;
+
+	current	     = chunk;
+	count_copies = 1u;
+
+	while (1) {
+		if (count_copies > min) {
+			if (unbounded) {
+				sub_chunk_zero_or_more(current);
+
+			} else {
+				/* pop patch node, skip to end of repetition */
+				patch = *patch_alloc;
+				++(*patch_alloc);
+
+				patch->state   = &current->start->skip;
+				patch->next    = NULL_POINTER;
+				*skips.end_ptr = patch;
+				skips.end_ptr  = &patch->next;
+			}
+		}
+
+		if (current != chunk)
+			concat_chunks(chunk,
+				      current);
+
+		if (count_copies == total_copies)
+			break;
+
+		status = fetch_copy(&copy,
+				    state_alloc,
+				    patch_alloc,
+				    operand,
+				    regex,
+				    is_sub_chunk);
+
+		if (status != 0)
+			return status;
+
+		current = &copy;
+		++count_copies;
+	}
+
+	if (skips.head != NULL_POINTER)
+		concat_patches(&chunk->patches,
+			       &skips);
+
+	return 0;
+}
+
+/* fetch next operand from pattern, repeated if followed by '{min,max}' */
+static inline int
+fetch_next_state(union TastyState *restrict *const restrict state,
+		 union TastyState *restrict *const restrict state_alloc,
+		 struct TastyPatch *restrict *const restrict patch_alloc,
+		 struct TastyPatchList *const restrict patches,
+		 const unsigned char *restrict *const restrict pattern_ptr,
+		 const struct TastyRegex *const restrict regex)
+{
+	struct TastyChunk chunk;
+
+	const unsigned char *const restrict operand = *pattern_ptr;
+
+	int status = fetch_next_atom(state,
+				     state_alloc,
+				     patch_alloc,
+				     &patches->head,
+				     pattern_ptr,
+				     regex);
+
+	if (   (status != 0)
+	    || (**pattern_ptr != '{')
+	    || !operand_repeatable(operand,
+				   *pattern_ptr))
+		return status;
+
+	chunk.start   = *state;
+	chunk.patches = *patches;
+
+	status = repeat_chunk(&chunk,
+			      state_alloc,
+			      patch_alloc,
+			      pattern_ptr,
+			      operand,
+			      regex,
+			      false);
+
+	*patches = chunk.patches;
+
+	return status;
+}
+
+/* apply any operator following sub chunk parsed from 'operand' */
+static inline int
+close_sub_chunk(struct TastyChunk *const restrict chunk,
+		union TastyState *restrict *const restrict state_alloc,
+		struct TastyPatch *restrict *const restrict patch_alloc,
+		const unsigned char *restrict *const restrict pattern_ptr,
+		const unsigned char *const restrict operand,
+		const struct TastyRegex *const restrict regex)
+{
+	switch (**pattern_ptr) {
+	case '*':
+		++(*pattern_ptr);
+		sub_chunk_zero_or_more(chunk);
+		return 0;
+
+	case '+':
+		++(*pattern_ptr);
+		sub_chunk_one_or_more(chunk,
+				      state_alloc,
+				      NODE_SPAN(regex));
+		return 0;
+
+	case '?':
+		++(*pattern_ptr);
+		sub_chunk_zero_or_one(chunk,
+				      patch_alloc);
+		return 0;
+
+	case '{':
+		return repeat_chunk(chunk,
+				    state_alloc,
+				    patch_alloc,
+				    pattern_ptr,
+				    operand,
+				    regex,
+				    true);
+
+	default: /* no nothing */
+		return 0;
+	}
+}
+
+
+int
+fetch_next_sub_chunk(struct TastyChunk *const restrict chunk,
+		     union TastyState *restrict *const restrict state_alloc,
+		     struct TastyPatch *restrict *const restrict patch_alloc,
+		     const unsigned char *restrict *const restrict pattern_ptr,
+		     const struct TastyRegex *const restrict regex)
 {
 	struct TastyChunk next_chunk;
 	union TastyState *restrict state;
 	struct TastyPatchList next_patches;
+	const unsigned char *restrict operand;
 	int status;
 
 	struct TastyPatchList *const restrict chunk_patches = &chunk->patches;
@@ -834,8 +4749,9 @@ fetch_next_sub_chunk(struct TastyChunk *const restrict chunk,
 	status = fetch_next_state(&chunk->start,
 				  state_alloc,
 				  patch_alloc,
-				  &chunk_patches->head,
-				  pattern_ptr);
+				  chunk_patches,
+				  pattern_ptr,
+				  regex);
 
 	switch (status) {
 	case 0: /* found next state */
@@ -850,17 +4766,22 @@ fetch_next_sub_chunk(struct TastyChunk *const restrict chunk,
 
 	case TASTY_CONTROL_PARENTHESES_OPEN:
 		++(*pattern_ptr);
+		operand = *pattern_ptr;
 		status = fetch_next_sub_chunk(chunk,
 					      state_alloc,
 					      patch_alloc,
-					      pattern_ptr);
-		if (status == 0) {
-			close_sub_chunk(chunk,
-					state_alloc,
-					patch_alloc,
-					pattern_ptr);
+					      pattern_ptr,
+					      regex);
+		if (status == 0)
+			status = close_sub_chunk(chunk,
+						 state_alloc,
+						 patch_alloc,
+						 pattern_ptr,
+						 operand,
+						 regex);
+		if (status == 0)
 			break;
-		} /* fall through */
+		/* fall through */
 	default: /* error */
 		return status;
 	}
@@ -873,8 +4794,9 @@ fetch_next_sub_chunk(struct TastyChunk *const restrict chunk,
 		status = fetch_next_state(&state,
 					  state_alloc,
 					  patch_alloc,
-					  &next_patches.head,
-					  pattern_ptr);
+					  &next_patches,
+					  pattern_ptr,
+					  regex);
 
 		switch (status) {
 		case 0: /* patch previous with next state */
@@ -896,24 +4818,31 @@ fetch_next_sub_chunk(struct TastyChunk *const restrict chunk,
 			status = fetch_next_sub_chunk(&next_chunk,
 						      state_alloc,
 						      patch_alloc,
-						      pattern_ptr);
+						      pattern_ptr,
+						      regex);
 			if (status == 0)
-				merge_chunks(chunk,
-					     &next_chunk);
+				status = merge_chunks(chunk,
+						      &next_chunk,
+						      NODE_SPAN(regex));
 
 			return status;
 
 		case TASTY_CONTROL_PARENTHESES_OPEN:
 			++(*pattern_ptr);
+			operand = *pattern_ptr;
 			status = fetch_next_sub_chunk(&next_chunk,
 						      state_alloc,
 						      patch_alloc,
-						      pattern_ptr);
+						      pattern_ptr,
+						      regex);
+			if (status == 0)
+				status = close_sub_chunk(&next_chunk,
+							 state_alloc,
+							 patch_alloc,
+							 pattern_ptr,
+							 operand,
+							 regex);
 			if (status == 0) {
-				close_sub_chunk(&next_chunk,
-						state_alloc,
-						patch_alloc,
-						pattern_ptr);
 				concat_chunks(chunk,
 					      &next_chunk);
 				continue;
@@ -928,11 +4857,13 @@ int
 fetch_next_chunk(struct TastyChunk *const restrict chunk,
 		 union TastyState *restrict *const restrict state_alloc,
 		 struct TastyPatch *restrict *const restrict patch_alloc,
-		 const unsigned char *restrict *const restrict pattern_ptr)
+		 const unsigned char *restrict *const restrict pattern_ptr,
+		 const struct TastyRegex *const restrict regex)
 {
 	struct TastyChunk next_chunk;
 	union TastyState *restrict state;
 	struct TastyPatchList next_patches;
+	const unsigned char *restrict operand;
 	int status;
 
 	struct TastyPatchList *const restrict chunk_patches = &chunk->patches;
@@ -944,8 +4875,9 @@ fetch_next_chunk(struct TastyChunk *const restrict chunk,
 	status = fetch_next_state(&chunk->start,
 				  state_alloc,
 				  patch_alloc,
-				  &chunk_patches->head,
-				  pattern_ptr);
+				  chunk_patches,
+				  pattern_ptr,
+				  regex);
 
 	switch (status) {
 	case 0: /* found next state */
@@ -960,17 +4892,21 @@ fetch_next_chunk(struct TastyChunk *const restrict chunk,
 
 	case TASTY_CONTROL_PARENTHESES_OPEN:
 		++(*pattern_ptr);
+		operand = *pattern_ptr;
 		status = fetch_next_sub_chunk(chunk,
 					      state_alloc,
 					      patch_alloc,
-					      pattern_ptr);
-		if (status == 0) {
-			close_sub_chunk(chunk,
-					state_alloc,
-					patch_alloc,
-					pattern_ptr);
+					      pattern_ptr,
+					      regex);
+		if (status == 0)
+			status = close_sub_chunk(chunk,
+						 state_alloc,
+						 patch_alloc,
+						 pattern_ptr,
+						 operand,
+						 regex);
+		if (status == 0)
 			break;
-		}
 		/* fall through */
 	default: /* error */
 		return status;
@@ -984,8 +4920,9 @@ fetch_next_chunk(struct TastyChunk *const restrict chunk,
 		status = fetch_next_state(&state,
 					  state_alloc,
 					  patch_alloc,
-					  &next_patches.head,
-					  pattern_ptr);
+					  &next_patches,
+					  pattern_ptr,
+					  regex);
 
 		switch (status) {
 		case 0: /* patch previous with next state */
@@ -1006,23 +4943,30 @@ fetch_next_chunk(struct TastyChunk *const restrict chunk,
 			status = fetch_next_chunk(&next_chunk,
 						  state_alloc,
 						  patch_alloc,
-						  pattern_ptr);
+						  pattern_ptr,
+						  regex);
 			if (status == 0)
-				merge_chunks(chunk,
-					     &next_chunk);
+				status = merge_chunks(chunk,
+						      &next_chunk,
+						      NODE_SPAN(regex));
 			return status;
 
 		case TASTY_CONTROL_PARENTHESES_OPEN:
 			++(*pattern_ptr);
+			operand = *pattern_ptr;
 			status = fetch_next_sub_chunk(&next_chunk,
 						      state_alloc,
 						      patch_alloc,
-						      pattern_ptr);
+						      pattern_ptr,
+						      regex);
+			if (status == 0)
+				status = close_sub_chunk(&next_chunk,
+							 state_alloc,
+							 patch_alloc,
+							 pattern_ptr,
+							 operand,
+							 regex);
 			if (status == 0) {
-				close_sub_chunk(&next_chunk,
-						state_alloc,
-						patch_alloc,
-						pattern_ptr);
 				concat_chunks(chunk,
 					      &next_chunk);
 				continue;
@@ -1035,55 +4979,98 @@ fetch_next_chunk(struct TastyChunk *const restrict chunk,
 
 static inline int
 compile_pattern(struct TastyRegex *const restrict regex,
-		union TastyState *restrict state_alloc,
+		union TastyState *const restrict state_base,
 		struct TastyPatch *restrict patch_alloc,
-		const unsigned char *restrict pattern)
+		const unsigned char *restrict pattern,
+		const unsigned int flags)
 {
 
 	struct TastyChunk chunk;
+	union TastyState *restrict state_alloc;
 	int status;
 
+	state_alloc = state_base;
+
 	status = fetch_next_chunk(&chunk,
 				  &state_alloc,
 				  &patch_alloc,
-				  &pattern);
+				  &pattern,
+				  regex);
 
-	if (status == 0) {
-		regex->initial	= chunk.start;
-		regex->matching = state_alloc;
+	if (status != 0)
+		return status;
 
-		patch_states(chunk.patches.head,
-			     state_alloc);
-	}
+	/* matching state row immediately follows last row popped */
+	patch_states(chunk.patches.head,
+		     state_alloc);
 
-	return status;
+	return build_state_table(regex,
+				 chunk.start,
+				 state_base,
+				 state_alloc,
+				 flags);
 }
 
 
 /* API
  * ────────────────────────────────────────────────────────────────────────── */
 int
-tasty_regex_compile(struct TastyRegex *const restrict regex,
-		    const char *restrict pattern)
+tasty_regex_compile_flags(struct TastyRegex *const restrict regex,
+			  const char *restrict pattern,
+			  const unsigned int flags)
 {
-	if (*pattern == '\0')
+	regex->flags   = flags;
+	regex->anchors = (flags & TASTY_COMPILE_MULTILINE)
+		       ? TASTY_ANCHOR_LINES
+		       : 0u;
+
+	/* leading '^' anchors start of pattern */
+	if (*pattern == '^') {
+		regex->anchors |= TASTY_ANCHOR_START;
+		++pattern;
+	}
+
+	if ((*pattern == '\0') || ((pattern[0] == '$') && (pattern[1] == '\0')))
 		return TASTY_ERROR_EMPTY_EXPRESSION;
 
-	const size_t length_pattern = nonempty_string_length(pattern);
+	struct TastyPatternSize size;
+
+	/* count number of state rows and patches needed */
+	size_pattern(&size,
+		     (const unsigned char *) pattern,
+		     flags);
+
+	if (size.anchor_end)
+		regex->anchors |= TASTY_ANCHOR_END;
+
+	/* partition bytes into classes, set width of state rows */
+	init_byte_classes(regex,
+			  &size);
+
+	if (   size.over_budget
+	    || ((size.count_states * NODE_SPAN(regex)) > TASTY_STATE_CELL_BUDGET))
+		return TASTY_ERROR_STATE_BUDGET;
+
+	/* a wildcard (or bracket) pushes a patch for every (member) byte
+	 * class */
+	size_t length_patches = size.count_patches
+			      + (size.count_wild_patches * regex->span);
+
+	/* pattern lacking operands still needs a node to report error from */
+	length_patches    += (length_patches == 0l);
+	size.count_states += (size.count_states == 0l);
 
-	/* allocate buffer of patch nodes for worst case pattern:
-	 * "........" (all wild, no operators) */
+	/* allocate buffer of patch nodes (exact, save for brackets) */
 	struct TastyPatch *const restrict patch_alloc
-	= malloc(sizeof(struct TastyPatch) * (length_pattern * UCHAR_MAX));
+	= malloc(sizeof(struct TastyPatch) * length_patches);
 
 	if (UNLIKELY(patch_alloc == NULL_POINTER))
 		return TASTY_ERROR_OUT_OF_MEMORY;
 
-	/* allocate buffer of state nodes for worst case pattern:
-	 * "abcdefgh" (no operators)
-	 * and initialize all pointers to NULL */
+	/* allocate exact buffer of state nodes and initialize all pointers to
+	 * NULL */
 	union TastyState *const restrict state_alloc
-	= calloc(length_pattern,
+	= calloc(size.count_states * NODE_SPAN(regex),
 		 sizeof(union TastyState));
 
 	if (UNLIKELY(state_alloc == NULL_POINTER)) {
@@ -1094,16 +5081,25 @@ tasty_regex_compile(struct TastyRegex *const restrict regex,
 	const int status = compile_pattern(regex,
 					   state_alloc,
 					   patch_alloc,
-					   (const unsigned char *) pattern);
-
-	if (status != 0)
-		free(state_alloc);
+					   (const unsigned char *) pattern,
+					   flags);
 
+	/* free temporary storage */
+	free(state_alloc);
 	free(patch_alloc);
 
 	return status;
 }
 
+int
+tasty_regex_compile(struct TastyRegex *const restrict regex,
+		    const char *restrict pattern)
+{
+	return tasty_regex_compile_flags(regex,
+					 pattern,
+					 0u);
+}
+
 
 /* free allocations */
 extern inline void
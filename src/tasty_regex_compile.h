@@ -12,17 +12,42 @@ extern "C" {
 #include <stdbool.h>	/* bool */
 
 
+/* helper macros
+ * ────────────────────────────────────────────────────────────────────────── */
+/* compile flags */
+#define TASTY_COMPILE_MINIMIZE	0x01u /* merge equivalent states (Hopcroft) */
+#define TASTY_COMPILE_MULTILINE	0x02u /* '^', '$' also anchor at newlines */
+#define TASTY_COMPILE_IGNORE_CASE 0x04u /* letters match in either case */
+#define TASTY_COMPILE_UTF8	0x08u /* '.', [] match whole UTF8 characters */
+
+/* rows beyond which TASTY_COMPILE_MINIMIZE is skipped */
+#define TASTY_MINIMIZE_STATE_LIMIT 16384
+
+/* greatest bound of repetition '{min,max}' */
+#define TASTY_REPEAT_MAX 1000
+
+/* most cells of state rows a pattern may compile to */
+#define TASTY_STATE_CELL_BUDGET (1l << 24)
+
+
 /* API
  * ────────────────────────────────────────────────────────────────────────── */
 int
 tasty_regex_compile(struct TastyRegex *const restrict regex,
 		    const char *restrict pattern);
 
+int
+tasty_regex_compile_flags(struct TastyRegex *const restrict regex,
+			  const char *restrict pattern,
+			  const unsigned int flags);
+
 /* free allocations */
 inline void
 tasty_regex_free(struct TastyRegex *const restrict regex)
 {
-	free((void *) regex->initial);
+	free((void *) regex->states);
+	free((void *) regex->row_steps);
+	free((void *) regex->row_preds);
 }
 
 #ifdef __cplusplus /* close 'extern "C" {' */
@@ -11,6 +11,8 @@ extern "C" {
  * ────────────────────────────────────────────────────────────────────────── */
 #include <stdlib.h>	/* size_t, m|calloc, free */
 #include <limits.h>	/* UCHAR_MAX, CHAR_BIT */
+#include <stdint.h>	/* uint32_t, UINT32_MAX */
+#include <stdbool.h>	/* bool */
 
 
 /* /1* system check */
@@ -28,20 +30,75 @@ extern "C" {
 #define TASTY_ERROR_INVALID_ESCAPE	   4 /* \[unescapeable char] */
 #define TASTY_ERROR_NO_OPERAND		   5 /* [*+?] preceeded by nothing */
 #define TASTY_ERROR_INVALID_UTF8	   6 /* non-UTF8 byte sequence */
+#define TASTY_ERROR_INVALID_BRACKET	   7 /* malformed [bracket] */
+#define TASTY_ERROR_INVALID_REPETITION	   8 /* bad bounds of X{min,max} */
+#define TASTY_ERROR_STATE_BUDGET	   9 /* needs too many states */
 
 
-/* typedefs, struct declarations
+/* state table encoding
  * ────────────────────────────────────────────────────────────────────────── */
-/* DFA state node, step['\0'] reserved for 'skip' field (no explicit match) */
-union TastyState {
-	union TastyState *step[UCHAR_MAX + 1]; /* jump tbl for non-'\0' */
-	union TastyState *skip;		     /* no match option */
-};
+#define TASTY_STATE_SPARSE    0x80000000u /* row stored as list of matches */
+#define TASTY_STATE_ACCEPTING 0x40000000u /* match closes if no step found */
+#define TASTY_STATE_OFFSET    0x3fffffffu /* mask of row offset in 'states' */
+
+/* longest literal recorded for skip-ahead, distance of no fixed bound */
+#define TASTY_LITERAL_LENGTH_MAX 32u
+#define TASTY_LEAD_UNBOUNDED	 UINT32_MAX
+
+/* anchors of a pattern, set in 'anchors' */
+#define TASTY_ANCHOR_START	0x01u /* '^', matches begin at start of input */
+#define TASTY_ANCHOR_END	0x02u /* '$', matches end at end of input */
+#define TASTY_ANCHOR_LINES	0x04u /* or at start/end of any line */
 
-/* complete DFA */
+/* most rows stored as a row set, dead end in 'row_steps' */
+#define TASTY_ROW_SET_MAX	64u
+#define TASTY_ROW_SET_DEAD	0xffu
+
+
+/* typedefs, struct declarations
+ * ────────────────────────────────────────────────────────────────────────── */
+/* complete DFA, a table of state rows referenced by their 32-bit offset in
+ * 'states' (offset 0 reserved for dead end).  Dense rows hold 'span' cells
+ * indexed by byte class, while low-fanout rows (TASTY_STATE_SPARSE set in
+ * offset) hold a count N, N byte classes, and N matching targets.  'skip'
+ * routes are flattened during compilation, so a row's explicit matches
+ * include those reachable by skipping, and TASTY_STATE_ACCEPTING is set in
+ * the offset of every row from which skipping reaches the end of the regex.
+ * Matches of a pattern with 'anchors' (TASTY_ANCHOR_*) set only begin or end
+ * where they allow.  'flags' holds the TASTY_COMPILE_* flags compiled with.
+ * Every match begins with the 'length_prefix' bytes of 'prefix' and contains
+ * the 'length_inner' bytes of 'inner', starting 'inner_lead_min' to
+ * 'inner_lead_max' bytes after the match, letting runs jump between candidate
+ * starts while no match is accumulating.  If 'has_start_set', only bytes B
+ * with (start_low[B & 0xf] & start_high[B >> 4]) != 0 may begin a match.
+ * Tables of at most TASTY_ROW_SET_MAX reachable rows are also numbered from 0
+ * (initial row) in 'row_steps', a 'span' × 'count_set_rows' matrix of next
+ * row numbers (TASTY_ROW_SET_DEAD if none), NULL otherwise, along with the
+ * reverse 'row_preds', the set of rows stepping into each row per class, and
+ * 'rows_closing', the set of accepting rows with no step per class (stored
+ * after 'row_preds'). */
 struct TastyRegex {
-	const union TastyState *restrict initial;
-	const union TastyState *restrict matching;
+	const uint32_t *restrict states;	/* reserved, rows */
+	uint32_t length_states;			/* cells in 'states' */
+	uint32_t initial;			/* offset of initial row */
+	uint32_t span;				/* count of byte classes */
+	unsigned char classes[UCHAR_MAX + 1];	/* byte → class (cell) */
+	unsigned int anchors;			/* TASTY_ANCHOR_* */
+	unsigned int flags;			/* TASTY_COMPILE_* */
+	uint32_t length_prefix;			/* bytes in 'prefix' */
+	uint32_t length_inner;			/* bytes in 'inner' */
+	uint32_t inner_lead_min;		/* least bytes before 'inner' */
+	uint32_t inner_lead_max;		/* most bytes before 'inner' */
+	unsigned char prefix[TASTY_LITERAL_LENGTH_MAX]; /* leads matches */
+	unsigned char inner[TASTY_LITERAL_LENGTH_MAX];	/* within matches */
+	bool has_start_set;			/* start_low|high filter */
+	unsigned char start_low[16];		/* low nibble → buckets */
+	unsigned char start_high[16];		/* high nibble → buckets */
+	uint32_t count_set_rows;		/* rows in 'row_steps' */
+	uint64_t rows_accepting;		/* set of accepting rows */
+	const unsigned char *restrict row_steps; /* class, row → row */
+	const uint64_t *restrict row_preds;	/* class, row → rows */
+	const uint64_t *restrict rows_closing;	/* class → rows */
 };
 
 #ifdef __cplusplus /* close 'extern "C" {' */
@@ -2,6 +2,10 @@
  * ────────────────────────────────────────────────────────────────────────── */
 #include "tasty_regex_run.h"
 #include "tasty_regex_utils.h"
+#include <string.h>	/* memcpy, memmove, memset, memcmp, memchr, memmem */
+#if defined(__AVX2__) || defined(__SSSE3__)
+#	include <immintrin.h> /* _mm(256)_shuffle_epi8, _mm(256)_movemask_epi8 */
+#endif /* if defined(__AVX2__) || defined(__SSSE3__) */
 
 
 /* helper macros
@@ -12,62 +16,330 @@
 #	define NULL_POINTER NULL    /* use traditional c null pointer macro */
 #endif /* ifdef __cplusplus */
 
+/* lazy DFA transition encoding */
+#define TASTY_LAZY_UNKNOWN	0xffffffffu /* transition not yet computed */
+#define TASTY_LAZY_EMIT		0x80000000u /* transition closes matches */
+#define TASTY_LAZY_ROW		0x7fffffffu /* mask of row offset in cache */
+
+#define TASTY_LAZY_SET_WORDS	8u  /* member words budgeted per set */
+#define TASTY_LAZY_FLUSH_MIN	10u /* bytes walked per cached set to flush */
+#define TASTY_LAZY_GIVE_UP	-1  /* fall back to accumulator walk */
+
+/* count of stream accumulators allocated at once */
+#define TASTY_STREAM_SLAB_LENGTH 256l
+
 
 /* typedefs, struct declarations
  * ────────────────────────────────────────────────────────────────────────── */
 /* used for tracking accumulating matches during run */
 struct TastyAccumulator {
-	const union TastyState *state;	 /* currently matching regex */
 	struct TastyAccumulator *next;	 /* next parallel matching state */
 	const unsigned char *match_from; /* beginning of string match */
+	uint32_t state;			 /* currently matching regex row */
+};
+
+/* used for tracking accumulating matches across fed chunks */
+struct TastyStreamAccumulator {
+	struct TastyStreamAccumulator *next; /* next parallel matching state */
+	size_t match_from;		     /* absolute offset of match start */
+	uint32_t state;			     /* currently matching regex row */
+};
+
+struct TastyStreamSlab {
+	struct TastyStreamSlab *next;
+	struct TastyStreamAccumulator accumulators[TASTY_STREAM_SLAB_LENGTH];
+};
+
+/* cache of lazily determinized sets of regex rows, each set a row of 'span'
+ * transitions followed by the offset and count of its sorted members */
+struct TastyLazyCache {
+	uint32_t *restrict rows;	/* transitions, member offset, count */
+	uint32_t *restrict slots;	/* hash of sets, holds row + 1 */
+	uint32_t *restrict members;	/* pool of set members */
+	uint32_t stride;		/* span + 2 */
+	uint32_t count_rows;		/* count of cached sets */
+	uint32_t capacity_rows;		/* max count of cached sets */
+	uint32_t mask_slots;		/* count of hash slots - 1 */
+	uint32_t count_members;		/* count of pooled members */
+	uint32_t capacity_members;	/* max count of pooled members */
+};
+
+/* regex row labeled with the row it leads to */
+struct TastyLazyTag {
+	uint32_t state;
+	uint32_t tag;
+};
+
+/* start of a running accumulator and the row it occupies */
+struct TastyLazyStart {
+	const unsigned char *from;
+	uint32_t state;
+};
+
+/* state of a lazy DFA walk */
+struct TastyLazyRun {
+	struct TastyLazyCache cache;
+	const struct TastyRegex *restrict regex;
+	const unsigned char *restrict string;
+	size_t length_string;
+	size_t floor;			      /* first valid 'trace' position */
+	uint32_t *restrict trace;	      /* set row at each position */
+	uint32_t *restrict set;		      /* successor set scratch */
+	struct TastyLazyTag *layers[2];	      /* walk back scratch */
+	struct TastyLazyStart *restrict starts; /* recovered starts scratch */
+	struct TastyLazyStart *pinned_block;  /* 2 buffers of pinned starts */
+	struct TastyLazyStart *pinned;	      /* starts running at 'floor' */
+	struct TastyLazyStart *pinned_until;
+	struct TastyMatch *restrict match_alloc;
 };
 
 
 /* helper functions
  * ────────────────────────────────────────────────────────────────────────── */
-static inline void
-push_next_acc(struct TastyAccumulator *restrict *const restrict acc_list,
-	      struct TastyAccumulator *restrict *const restrict acc_alloc,
-	      const struct TastyRegex *const restrict regex,
-	      const unsigned char *const restrict string)
+static inline uint32_t
+state_step(const uint32_t *const restrict states,
+	   const uint32_t state,
+	   const unsigned int token)
 {
-	const union TastyState *restrict state;
-	const union TastyState *restrict next_state;
+	const uint32_t *restrict match_from;
 
-	state = regex->initial;
+	/* dense row, jump straight to target */
+	if (LIKELY((state & TASTY_STATE_SPARSE) == 0u))
+		return states[(state & TASTY_STATE_OFFSET) + token];
 
-	while (1) {
-		next_state = state->step[*string];
+	/* sparse row: count, classes, targets */
+	match_from = &states[state & TASTY_STATE_OFFSET];
 
-		/* if no match on string */
-		if (next_state == NULL_POINTER) {
-			/* check skip route */
-			next_state = state->skip;
+	const uint32_t count_matches = *match_from;
+	++match_from;
 
-			/* if DNE or skipped all the way to end w/o explicit
-			 * match, do not add new acc to acc_list */
-			if (   (next_state == NULL_POINTER)
-			    || (next_state == regex->matching))
-				return;
+	const uint32_t *const restrict match_until = match_from + count_matches;
 
-			state = next_state;
+	while (match_from < match_until) {
+		if (*match_from == token)
+			return match_from[count_matches];
 
-		/* explicit match */
-		} else {
-			/* pop a fresh accumulator node */
-			struct TastyAccumulator *const restrict acc
-			= *acc_alloc;
-			++(*acc_alloc);
+		++match_from;
+	}
 
-			/* populate it and push into acc_list */
-			acc->state	= next_state;
-			acc->next	= *acc_list;
-			acc->match_from	= string;
+	return 0u; /* no explicit match */
+}
 
-			*acc_list = acc;
-			return;
-		}
+/* first position at or after 'string' from which a match could reach an
+ * occurrence of the inner literal of 'regex' (cached in 'hit'), or
+ * 'string_until' if there is none */
+static inline const unsigned char *
+skip_to_candidate(const struct TastyRegex *const restrict regex,
+		  const unsigned char *const restrict string,
+		  const unsigned char *const restrict string_until,
+		  const unsigned char *restrict *const restrict hit)
+{
+	const void *restrict found;
+
+	const size_t lead_min	  = regex->inner_lead_min;
+	const size_t length_inner = regex->length_inner;
+
+	/* last occurrence found lies behind earliest reachable */
+	if (   (*hit == NULL_POINTER)
+	    || ((size_t) (*hit - string) < lead_min)
+	    || (*hit < string)) {
+		if ((size_t) (string_until - string) < (lead_min + length_inner))
+			return string_until;
+
+		if (length_inner == 1u)
+			found = memchr(string + lead_min,
+				       regex->inner[0],
+				       (string_until - string) - lead_min);
+		else
+			found = memmem(string + lead_min,
+				       (string_until - string) - lead_min,
+				       &regex->inner[0],
+				       length_inner);
+
+		if (found == NULL_POINTER)
+			return string_until;
+
+		*hit = (const unsigned char *) found;
+	}
+
+	/* earliest start leading to 'hit' */
+	if (   (regex->inner_lead_max == TASTY_LEAD_UNBOUNDED)
+	    || ((size_t) (*hit - string) <= regex->inner_lead_max))
+		return string;
+
+	return *hit - regex->inner_lead_max;
+}
+
+/* first position at or after 'string' holding a byte in the start set of
+ * 'regex' (or a false candidate sharing its buckets), or 'string_until' */
+static inline const unsigned char *
+scan_start_set(const struct TastyRegex *const restrict regex,
+	       const unsigned char *restrict string,
+	       const unsigned char *const restrict string_until)
+{
+	const unsigned char *const restrict low  = &regex->start_low[0];
+	const unsigned char *const restrict high = &regex->start_high[0];
+
+#ifdef __AVX2__
+	const __m256i low_table	 = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *) low)
+	);
+	const __m256i high_table = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *) high)
+	);
+	const __m256i nibble	 = _mm256_set1_epi8(0x0f);
+	const __m256i zero	 = _mm256_setzero_si256();
+
+	/* classify 32 bytes at once */
+	while ((string_until - string) >= 32l) {
+		const __m256i chunk = _mm256_loadu_si256((const __m256i *) string);
+
+		const __m256i buckets = _mm256_and_si256(
+			_mm256_shuffle_epi8(low_table,
+					    _mm256_and_si256(chunk,
+							     nibble)),
+			_mm256_shuffle_epi8(high_table,
+					    _mm256_and_si256(_mm256_srli_epi16(chunk,
+									       4),
+							     nibble))
+		);
+
+		const uint32_t candidates = ~((uint32_t) _mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(buckets,
+					  zero)
+		));
+
+		if (candidates != 0u)
+			return string + __builtin_ctz(candidates);
+
+		string += 32l;
+	}
+#elif defined(__SSSE3__)
+	const __m128i low_table	 = _mm_loadu_si128((const __m128i *) low);
+	const __m128i high_table = _mm_loadu_si128((const __m128i *) high);
+	const __m128i nibble	 = _mm_set1_epi8(0x0f);
+	const __m128i zero	 = _mm_setzero_si128();
+
+	/* classify 16 bytes at once */
+	while ((string_until - string) >= 16l) {
+		const __m128i chunk = _mm_loadu_si128((const __m128i *) string);
+
+		const __m128i buckets = _mm_and_si128(
+			_mm_shuffle_epi8(low_table,
+					 _mm_and_si128(chunk,
+						       nibble)),
+			_mm_shuffle_epi8(high_table,
+					 _mm_and_si128(_mm_srli_epi16(chunk,
+								      4),
+						       nibble))
+		);
+
+		const uint32_t candidates = 0xffffu
+					  & ~((uint32_t) _mm_movemask_epi8(
+			_mm_cmpeq_epi8(buckets,
+				       zero)
+		));
+
+		if (candidates != 0u)
+			return string + __builtin_ctz(candidates);
+
+		string += 16l;
+	}
+#endif /* ifdef __AVX2__ */
+
+	/* remaining bytes, one at a time */
+	while (string < string_until) {
+		if (low[*string & 0x0fu] & high[*string >> 4])
+			return string;
+
+		++string;
 	}
+
+	return string_until;
+}
+
+/* whether a match of 'regex' may begin at 'string' ('string_from' is the
+ * start of input) */
+static inline bool
+anchor_allows_start(const struct TastyRegex *const restrict regex,
+		    const unsigned char *const restrict string_from,
+		    const unsigned char *const restrict string)
+{
+	if (   ((regex->anchors & TASTY_ANCHOR_START) == 0u)
+	    || (string == string_from))
+		return true;
+
+	return (regex->anchors & TASTY_ANCHOR_LINES)
+	    && (string[-1] == '\n');
+}
+
+/* TASTY_STATE_ACCEPTING if a match of 'regex' may end at 'string', else 0 */
+static inline uint32_t
+anchor_accepting(const struct TastyRegex *const restrict regex,
+		 const unsigned char *const restrict string,
+		 const unsigned char *const restrict string_until)
+{
+	if (   ((regex->anchors & TASTY_ANCHOR_END) == 0u)
+	    || (string == string_until)
+	    || (   (regex->anchors & TASTY_ANCHOR_LINES)
+		&& (*string == '\n')))
+		return TASTY_STATE_ACCEPTING;
+
+	return 0u;
+}
+
+/* first position at or after 'string' a start-anchored match may begin at,
+ * or 'string_until' if there is none */
+static inline const unsigned char *
+skip_to_anchor(const struct TastyRegex *const restrict regex,
+	       const unsigned char *const restrict string_from,
+	       const unsigned char *const restrict string,
+	       const unsigned char *const restrict string_until)
+{
+	const unsigned char *restrict line;
+
+	if (anchor_allows_start(regex,
+				string_from,
+				string))
+		return string;
+
+	if ((regex->anchors & TASTY_ANCHOR_LINES) == 0u)
+		return string_until;
+
+	line = memchr(string,
+		      '\n',
+		      string_until - string);
+
+	return (line == NULL_POINTER)
+	     ? string_until
+	     : (line + 1);
+}
+
+static inline void
+push_next_acc(struct TastyAccumulator *restrict *const restrict acc_list,
+	      struct TastyAccumulator *restrict *const restrict acc_alloc,
+	      const struct TastyRegex *const restrict regex,
+	      const unsigned char *const restrict string,
+	      const unsigned int token)
+{
+	const uint32_t next_state = state_step(regex->states,
+					       regex->initial,
+					       token);
+
+	/* if no explicit match, do not add new acc to acc_list */
+	if (next_state == 0u)
+		return;
+
+	/* pop a fresh accumulator node */
+	struct TastyAccumulator *const restrict acc = *acc_alloc;
+	++(*acc_alloc);
+
+	/* populate it and push into acc_list */
+	acc->state	= next_state;
+	acc->next	= *acc_list;
+	acc->match_from	= string;
+
+	*acc_list = acc;
 }
 
 
@@ -89,199 +361,2218 @@ push_match(struct TastyMatch *restrict *const restrict match_alloc,
 static inline void
 acc_list_process(struct TastyAccumulator *restrict *restrict acc_ptr,
 		 struct TastyMatch *restrict *const restrict match_alloc,
-		 const union TastyState *const restrict matching,
-		 const unsigned char *const restrict string)
+		 const uint32_t *const restrict states,
+		 const unsigned char *const restrict string,
+		 const unsigned int token,
+		 const uint32_t accepting)
 {
 	struct TastyAccumulator *restrict acc;
-	const union TastyState *restrict state;
-	const union TastyState *restrict next_state;
+	uint32_t state;
+	uint32_t next_state;
 
 	acc = *acc_ptr;
 
 	while (acc != NULL_POINTER) {
-		state = acc->state;
+		state	   = acc->state;
+		next_state = state_step(states,
+					state,
+					token);
+
+		/* explicit match found, update acc */
+		if (next_state != 0u) {
+			acc->state = next_state;
+
+			acc_ptr = &acc->next;
+			acc	= acc->next;
+			continue;
+		}
 
-		/* if last step was a match */
-		if (state == matching) {
-			/* push new match */
+		/* if skipping reaches end of regex, close match */
+		if (state & accepting)
 			push_match(match_alloc,
 				   acc->match_from,
 				   string);
 
-			/* remove acc from list */
-			acc	 = acc->next;
-			*acc_ptr = acc;
-
-		/* step to next state */
-		} else {
-			while (1) {
-				next_state = state->step[*string];
-
-				/* if no match on string */
-				if (next_state == NULL_POINTER) {
-					/* check skip route */
-					next_state = state->skip;
-
-					/* if DNE */
-					if (next_state == NULL_POINTER) {
-						/* remove acc from list */
-						acc	 = acc->next;
-						*acc_ptr = acc;
-						break;
-
-					/* if skipped all the way to end w/o
-					 * explicit match, close match */
-					} else if (next_state == matching) {
-						/* push new match */
-						push_match(match_alloc,
-							   acc->match_from,
-							   string);
-
-						/* remove acc from list */
-						acc	 = acc->next;
-						*acc_ptr = acc;
-						break;
-					}
-
-					/* continue looking for explicit
-					 * match */
-					state = next_state;
-
-				/* explicit match found, update acc */
-				} else {
-					/* update accumulator state and
-					 * traversal vars */
-					acc->state = next_state;
-
-					acc_ptr = &acc->next;
-					acc	= acc->next;
-					break;
-				}
-			}
-		}
+		/* remove acc from list */
+		acc	 = acc->next;
+		*acc_ptr = acc;
 	}
 }
 
 static inline void
 acc_list_final_scan(struct TastyAccumulator *restrict acc,
 		    struct TastyMatch *restrict *const restrict match_alloc,
-		    const union TastyState *const restrict matching,
 		    const unsigned char *const restrict string)
 {
-	const union TastyState *restrict state;
-
 	while (acc != NULL_POINTER) {
-		state = acc->state;
-
-		/* if last step was a match */
-		if (state == matching) {
-			/* push new match */
+		/* if skipping reaches end of regex, record match */
+		if (acc->state & TASTY_STATE_ACCEPTING)
 			push_match(match_alloc,
 				   acc->match_from,
 				   string);
 
-		/* check if skip route can match */
-		} else {
-			while (1) {
-				state = state->skip;
-
-				/* if dead end, bail */
-				if (state == NULL_POINTER)
-					break;
-
-				/* if skipping yields match, record */
-				if (state == matching) {
-					/* push new match */
-					push_match(match_alloc,
-						   acc->match_from,
-						   string);
-					break;
-				}
-			}
+		acc = acc->next;
+	}
+}
+
+
+static inline int
+acc_list_process_callback(struct TastyAccumulator *restrict *restrict acc_ptr,
+			  const uint32_t *const restrict states,
+			  const unsigned char *const restrict string,
+			  const unsigned int token,
+			  const uint32_t accepting,
+			  const TastyMatchCallback callback,
+			  void *const user)
+{
+	struct TastyAccumulator *restrict acc;
+	struct TastyMatch match;
+	uint32_t state;
+	uint32_t next_state;
+	int status;
+
+	acc = *acc_ptr;
+
+	while (acc != NULL_POINTER) {
+		state	   = acc->state;
+		next_state = state_step(states,
+					state,
+					token);
+
+		/* explicit match found, update acc */
+		if (next_state != 0u) {
+			acc->state = next_state;
+
+			acc_ptr = &acc->next;
+			acc	= acc->next;
+			continue;
+		}
+
+		/* remove acc from list */
+		*acc_ptr = acc->next;
+
+		/* if skipping reaches end of regex, report match */
+		if (state & accepting) {
+			match.from  = (const char *) acc->match_from;
+			match.until = (const char *) string;
+
+			status = callback(user,
+					  &match);
+			if (status != 0)
+				return status;
+		}
+
+		acc = *acc_ptr;
+	}
+
+	return 0;
+}
+
+static inline int
+acc_list_final_scan_callback(struct TastyAccumulator *restrict acc,
+			     const unsigned char *const restrict string,
+			     const TastyMatchCallback callback,
+			     void *const user)
+{
+	struct TastyMatch match;
+	int status;
+
+	while (acc != NULL_POINTER) {
+		/* if skipping reaches end of regex, report match */
+		if (acc->state & TASTY_STATE_ACCEPTING) {
+			match.from  = (const char *) acc->match_from;
+			match.until = (const char *) string;
+
+			status = callback(user,
+					  &match);
+			if (status != 0)
+				return status;
 		}
 
 		acc = acc->next;
 	}
+
+	return 0;
 }
 
 
-/* API
+/* row set walk
+ * ──────────────────────────────────────────────────────────────────────────
+ * For tables with a row set the walk forward tracks only the rows occupied
+ * by any running match, as the bits of a single 64-bit word, and so finds
+ * where matches close but not where they began.  The starts of the matches
+ * closing at a position are then recovered by walking back over the reverse
+ * table: a row leads to the closing rows if stepping it on the bytes between
+ * does, and a match began wherever the initial row steps into such a row.
+ * As the table is deterministic no start is found twice, and starts are
+ * found in descending order, the order matches closing together are
+ * reported in.  The walk back stops once no row leads to the closing rows,
+ * or at the last position no match was running.
  * ────────────────────────────────────────────────────────────────────────── */
-int
-tasty_regex_run(const struct TastyRegex *const restrict regex,
-		struct TastyMatchInterval *const restrict matches,
-		const char *restrict string)
+static inline uint64_t
+row_set_step(const struct TastyRegex *const restrict regex,
+	     uint64_t rows,
+	     const unsigned int token,
+	     const bool may_start)
 {
-	struct TastyMatch *restrict match_alloc;
-	struct TastyAccumulator *restrict acc_alloc;
-	struct TastyAccumulator *restrict acc_list;
+	uint64_t next_rows;
+	unsigned int next_row;
 
-	/* want to ensure at least 1 non-'\0' char before start of walk */
-	if (*string == '\0') {
-		matches->from  = NULL_POINTER;
-		matches->until = NULL_POINTER;
-		return 0;
+	const unsigned char *const restrict steps
+	= regex->row_steps + (token * regex->count_set_rows);
+
+	/* initial row is row 0, walk only jumps to where a match may start */
+	rows	 |= (uint64_t) may_start;
+	next_rows = 0u;
+
+	do {
+		next_row = steps[__builtin_ctzll(rows)];
+		rows    &= rows - 1u;
+
+		if (next_row != TASTY_ROW_SET_DEAD)
+			next_rows |= UINT64_C(1) << next_row;
+	} while (rows != 0u);
+
+	return next_rows;
+}
+
+/* report matches ending at 'until' of all accumulators occupying 'closing'
+ * rows, starting no earlier than 'floor' ('string_from' is the start of
+ * input) */
+static inline int
+row_set_close(const struct TastyRegex *const restrict regex,
+	      const unsigned char *const restrict string_from,
+	      const unsigned char *const restrict floor,
+	      const unsigned char *const restrict until,
+	      uint64_t closing,
+	      const TastyMatchCallback callback,
+	      void *const user)
+{
+	struct TastyMatch match;
+	const uint64_t *restrict preds;
+	uint64_t leading;
+	unsigned int token;
+	unsigned int first_row;
+	int status;
+
+	const uint32_t count_rows = regex->count_set_rows;
+
+	const unsigned char *restrict string = until;
+
+	match.until = (const char *) until;
+
+	while ((closing != 0u) && (string > floor)) {
+		--string;
+
+		token = regex->classes[*string];
+
+		/* accumulator started at 'string' */
+		first_row = regex->row_steps[token * count_rows];
+
+		if (   (first_row != TASTY_ROW_SET_DEAD)
+		    && (closing & (UINT64_C(1) << first_row))
+		    && anchor_allows_start(regex,
+					   string_from,
+					   string)) {
+			match.from = (const char *) string;
+
+			status = callback(user,
+					  &match);
+			if (status != 0)
+				return status;
+		}
+
+		/* rows leading to 'closing' one byte earlier */
+		preds	= regex->row_preds + (token * count_rows);
+		leading = 0u;
+
+		do {
+			leading |= preds[__builtin_ctzll(closing)];
+			closing &= closing - 1u;
+		} while (closing != 0u);
+
+		closing = leading;
 	}
 
-	const size_t length_string = nonempty_string_length(string);
+	return 0;
+}
+
+static inline int
+walk_row_set(const struct TastyRegex *const restrict regex,
+	     const unsigned char *restrict string,
+	     const size_t length_string,
+	     const TastyMatchCallback callback,
+	     void *const user)
+{
+	const unsigned char *restrict floor;
+	uint64_t occupied;
+	uint64_t closing;
+	unsigned int token;
+	int status;
 
-	/* at most N matches */
-	match_alloc = malloc(sizeof(struct TastyMatch) * length_string);
+	const unsigned char *const restrict classes = &regex->classes[0];
+	const unsigned char *const restrict string_until = string
+							 + length_string;
+	const unsigned char *restrict hit = NULL_POINTER;
 
-	if (UNLIKELY(match_alloc == NULL_POINTER))
-		return TASTY_ERROR_OUT_OF_MEMORY;
+	const bool has_inner  = (regex->length_inner > 0u);
+	const bool has_anchor = ((regex->anchors & TASTY_ANCHOR_START) != 0u);
 
-	/* at most N running accumulators */
-	struct TastyAccumulator *const restrict accumulators
-	= malloc(sizeof(struct TastyAccumulator) * length_string);
+	const unsigned char *const restrict string_from = string;
 
-	if (UNLIKELY(accumulators == NULL_POINTER)) {
-		free(match_alloc);
-		return TASTY_ERROR_OUT_OF_MEMORY;
+	floor	 = string;
+	occupied = 0u;
+
+	/* walk string */
+	while (1) {
+		/* nothing accumulating: jump to next candidate start */
+		if (occupied == 0u) {
+			if (has_inner)
+				string = skip_to_candidate(regex,
+							   string,
+							   string_until,
+							   &hit);
+
+			if (regex->has_start_set)
+				string = scan_start_set(regex,
+							string,
+							string_until);
+
+			if (has_anchor)
+				string = skip_to_anchor(regex,
+							string_from,
+							string,
+							string_until);
+
+			if (string == string_until)
+				return 0;
+
+			floor = string;
+		}
+
+		token = classes[*string];
+
+		/* rows with no explicit match close if skipping reaches end */
+		closing = (anchor_accepting(regex,
+					    string,
+					    string_until) != 0u)
+			? (occupied & regex->rows_closing[token])
+			: 0u;
+
+		if (closing != 0u) {
+			status = row_set_close(regex,
+					       string_from,
+					       floor,
+					       string,
+					       closing,
+					       callback,
+					       user);
+			if (status != 0)
+				return status; /* stopped by callback */
+		}
+
+		occupied = row_set_step(regex,
+					occupied,
+					token,
+					anchor_allows_start(regex,
+							    string_from,
+							    string));
+
+		++string;
+
+		if (string == string_until)
+			break;
 	}
 
-	acc_alloc = accumulators;	/* point acc_alloc to valid memory */
-	acc_list  = NULL_POINTER;	/* initialize acc_list to empty */
-	matches->from = match_alloc;	/* set start of match interval */
+	/* report matches of accepting rows */
+	return row_set_close(regex,
+			     string_from,
+			     floor,
+			     string_until,
+			     occupied & regex->rows_accepting,
+			     callback,
+			     user);
+}
+
+static int
+append_match(void *user,
+	     const struct TastyMatch *const restrict match)
+{
+	push_match((struct TastyMatch **) user,
+		   (const unsigned char *) match->from,
+		   (const unsigned char *) match->until);
+
+	return 0;
+}
+
+
+/* walk of accumulators reporting each match to 'callback', shared by the
+ * callback, test, and count runs (constant callbacks are inlined) */
+static inline int
+walk_callback(const struct TastyRegex *const restrict regex,
+	      struct TastyAccumulator *restrict acc_alloc,
+	      const unsigned char *restrict string,
+	      const size_t length_string,
+	      const TastyMatchCallback callback,
+	      void *const user)
+{
+	struct TastyAccumulator *restrict acc_list;
+	int status;
+
+	if (regex->row_steps != NULL_POINTER)
+		return walk_row_set(regex,
+				    string,
+				    length_string,
+				    callback,
+				    user);
+
+	const unsigned char *const restrict classes = &regex->classes[0];
+	const unsigned char *const restrict string_until = string
+							 + length_string;
+
+	acc_list = NULL_POINTER;
+
+	const unsigned char *restrict hit = NULL_POINTER;
+
+	const bool has_inner  = (regex->length_inner > 0u);
+	const bool has_anchor = ((regex->anchors & TASTY_ANCHOR_START) != 0u);
+
+	const unsigned char *const restrict string_from = string;
 
 	/* walk string */
 	while (1) {
+		/* nothing accumulating: jump to next candidate start */
+		if (acc_list == NULL_POINTER) {
+			if (has_inner)
+				string = skip_to_candidate(regex,
+							   string,
+							   string_until,
+							   &hit);
+
+			if (regex->has_start_set)
+				string = scan_start_set(regex,
+							string,
+							string_until);
+
+			if (has_anchor)
+				string = skip_to_anchor(regex,
+							string_from,
+							string,
+							string_until);
+
+			if (string == string_until)
+				return 0;
+		}
+
 		/* push next acc if explicit start of match found */
-		push_next_acc(&acc_list,
-			      &acc_alloc,
-			      regex,
-			      (const unsigned char *) string);
+		if (anchor_allows_start(regex,
+					string_from,
+					string))
+			push_next_acc(&acc_list,
+				      &acc_alloc,
+				      regex,
+				      string,
+				      classes[*string]);
 
 		++string;
 
-		if (*string == '\0')
-			break;
+		if (string == string_until) {
+			/* report matches found in acc_list */
+			return acc_list_final_scan_callback(acc_list,
+							    string,
+							    callback,
+							    user);
+		}
 
 		/* traverse acc_list: update states, prune dead-end accs, and
-		 * append matches */
-		acc_list_process(&acc_list,
-				 &match_alloc,
-				 regex->matching,
-				 (const unsigned char *) string);
+		 * report matches */
+		status = acc_list_process_callback(&acc_list,
+						   regex->states,
+						   string,
+						   classes[*string],
+						   anchor_accepting(regex,
+								    string,
+								    string_until),
+						   callback,
+						   user);
+		if (status != 0)
+			return status; /* stopped by callback */
 	}
+}
 
-	/* append matches found in acc_list */
-	acc_list_final_scan(acc_list,
-			    &match_alloc,
-			    regex->matching,
-			    (const unsigned char *) string);
+static int
+stop_at_match(void *user,
+	      const struct TastyMatch *match)
+{
+	(void) user;
+	(void) match;
 
-	/* close match interval */
-	matches->until = match_alloc;
+	return 1;
+}
 
-	/* free temporary storage */
-	free(accumulators);
+static int
+count_match(void *user,
+	    const struct TastyMatch *match)
+{
+	(void) match;
+
+	++(*((size_t *) user));
 
-	/* return success */
 	return 0;
 }
 
 
-/* free allocations */
-extern inline void
-tasty_match_interval_free(struct TastyMatchInterval *const restrict matches);
+/* lazy DFA
+ * ──────────────────────────────────────────────────────────────────────────
+ * Sets of regex rows occupied by running accumulators are determinized on
+ * demand and cached as rows of 'span' transitions, so the walk performs one
+ * lookup per input byte no matter how many matches are in flight.  Only end
+ * positions are tracked while walking; the starts of closed matches are
+ * recovered by walking the trace of visited sets backwards.  When the cache
+ * fills it is flushed, and the starts still running at that point are pinned
+ * to the rows they occupy so that earlier trace entries may be discarded. */
+static inline uint32_t
+lazy_set_hash(const uint32_t *restrict member,
+	      const uint32_t *const restrict member_until)
+{
+	uint32_t hash = 2166136261u; /* FNV-1a over member offsets */
+
+	while (member < member_until) {
+		hash ^= *member;
+		hash *= 16777619u;
+		++member;
+	}
+
+	return hash;
+}
+
+static inline void
+lazy_cache_clear(struct TastyLazyCache *const restrict cache)
+{
+	cache->count_rows    = 0u;
+	cache->count_members = 0u;
+
+	(void) memset(cache->slots,
+		      0,
+		      sizeof(uint32_t) * (cache->mask_slots + 1u));
+}
+
+static inline int
+lazy_cache_init(struct TastyLazyCache *const restrict cache,
+		const size_t budget,
+		const uint32_t span)
+{
+	uint32_t count_slots;
+
+	const size_t stride	   = ((size_t) span) + 2u;
+	const size_t budget_words  = budget / sizeof(uint32_t);
+	const size_t capacity_rows = budget_words
+				   / (stride + 4u + TASTY_LAZY_SET_WORDS);
+
+	/* need room for at least the current set and its successor */
+	if ((capacity_rows < 2u) || (capacity_rows > TASTY_LAZY_ROW / stride))
+		return TASTY_LAZY_GIVE_UP;
+
+	/* largest power of 2 ≤ 4 * capacity, keeps load factor under 1/2 */
+	count_slots = 1u;
+	while (count_slots <= (capacity_rows * 2u))
+		count_slots <<= 1;
+
+	uint32_t *const restrict block = malloc(sizeof(uint32_t)
+						* budget_words);
+
+	if (UNLIKELY(block == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	cache->rows		= block;
+	cache->slots		= block + (capacity_rows * stride);
+	cache->members		= cache->slots + count_slots;
+	cache->stride		= (uint32_t) stride;
+	cache->capacity_rows	= (uint32_t) capacity_rows;
+	cache->mask_slots	= count_slots - 1u;
+	cache->capacity_members = (uint32_t) (budget_words
+					      - (capacity_rows * stride)
+					      - count_slots);
+
+	lazy_cache_clear(cache);
+
+	return 0;
+}
+
+/* returns row of cached set, TASTY_LAZY_UNKNOWN if cache is full */
+static inline uint32_t
+lazy_cache_intern(struct TastyLazyCache *const restrict cache,
+		  const uint32_t *const restrict set,
+		  const uint32_t count_set)
+{
+	uint32_t *restrict slot;
+	uint32_t *restrict cell;
+	uint32_t row;
+
+	const uint32_t span = cache->stride - 2u;
+	uint32_t index	    = lazy_set_hash(set,
+					    set + count_set);
+
+	while (1) {
+		index &= cache->mask_slots;
+		slot   = &cache->slots[index];
+
+		if (*slot == 0u)
+			break;
+
+		row  = *slot - 1u;
+		cell = &cache->rows[row + span];
+
+		if (   (cell[1] == count_set)
+		    && (memcmp(&cache->members[cell[0]],
+			       set,
+			       sizeof(uint32_t) * count_set) == 0))
+			return row; /* set already cached */
+
+		++index;
+	}
+
+	if (   (cache->count_rows == cache->capacity_rows)
+	    || (count_set > (cache->capacity_members - cache->count_members)))
+		return TASTY_LAZY_UNKNOWN;
+
+	row   = cache->count_rows * cache->stride;
+	*slot = row + 1u;
+	++cache->count_rows;
+
+	/* transitions are computed as they are first taken */
+	cell = &cache->rows[row];
+	(void) memset(cell,
+		      0xff,
+		      sizeof(uint32_t) * span);
+
+	cell[span]	= cache->count_members;
+	cell[span + 1u] = count_set;
+
+	(void) memcpy(&cache->members[cache->count_members],
+		      set,
+		      sizeof(uint32_t) * count_set);
+
+	cache->count_members += count_set;
+
+	return row;
+}
+
+static inline const uint32_t *
+lazy_cache_members(const struct TastyLazyCache *const restrict cache,
+		   const uint32_t row,
+		   uint32_t *const restrict count_set)
+{
+	const uint32_t *const restrict cell = &cache->rows[row
+							   + cache->stride
+							   - 2u];
+	*count_set = cell[1];
+
+	return &cache->members[cell[0]];
+}
+
+/* insert 'state' into sorted 'set', ignoring duplicates */
+static inline uint32_t
+lazy_set_insert(uint32_t *const restrict set,
+		uint32_t count_set,
+		const uint32_t state)
+{
+	uint32_t *restrict member = set + count_set;
+
+	while ((member > set) && (member[-1] > state))
+		--member;
+
+	if ((member > set) && (member[-1] == state))
+		return count_set;
+
+	(void) memmove(member + 1,
+		       member,
+		       sizeof(uint32_t) * ((set + count_set) - member));
+	*member = state;
+
+	return count_set + 1u;
+}
+
+/* binary search layer sorted by state, returns NULL_POINTER if absent */
+static inline const struct TastyLazyTag *
+lazy_layer_find(const struct TastyLazyTag *restrict from,
+		const struct TastyLazyTag *restrict until,
+		const uint32_t state)
+{
+	const struct TastyLazyTag *restrict middle;
+
+	while (from < until) {
+		middle = from + ((until - from) / 2);
+
+		if (middle->state == state)
+			return middle;
+
+		if (middle->state < state)
+			from = middle + 1;
+		else
+			until = middle;
+	}
+
+	return NULL_POINTER;
+}
+
+/* Recover the starts of all accumulators occupying the rows of 'layer' at
+ * position 'until'.  Starts are written to 'starts' newest first, tagged
+ * with the row of 'layer' they reach. */
+static inline struct TastyLazyStart *
+lazy_walk_back(struct TastyLazyRun *const restrict run,
+	       struct TastyLazyTag *restrict layer,
+	       uint32_t count_layer,
+	       size_t until,
+	       struct TastyLazyStart *restrict starts)
+{
+	struct TastyLazyTag *restrict next_layer;
+	struct TastyLazyTag *restrict swap;
+	const struct TastyLazyTag *restrict found;
+	const struct TastyLazyStart *restrict pinned;
+	const uint32_t *restrict member;
+	const uint32_t *restrict member_until;
+	uint32_t count_set;
+	uint32_t count_next;
+	unsigned int token;
+
+	const uint32_t *const restrict states = run->regex->states;
+
+	next_layer = (layer == run->layers[0])
+		   ? run->layers[1]
+		   : run->layers[0];
+
+	while (until > run->floor) {
+		--until;
+
+		token = run->regex->classes[run->string[until]];
+
+		/* accumulator started at 'until' */
+		found = lazy_layer_find(layer,
+					layer + count_layer,
+					state_step(states,
+						   run->regex->initial,
+						   token));
+		if (found != NULL_POINTER) {
+			starts->from  = run->string + until;
+			starts->state = found->tag;
+			++starts;
+		}
+
+		/* predecessors of 'layer' among rows occupied at 'until' */
+		member = lazy_cache_members(&run->cache,
+					    run->trace[until],
+					    &count_set);
+		member_until = member + count_set;
+		count_next   = 0u;
+
+		while (member < member_until) {
+			found = lazy_layer_find(layer,
+						layer + count_layer,
+						state_step(states,
+							   *member,
+							   token));
+			if (found != NULL_POINTER) {
+				next_layer[count_next].state = *member;
+				next_layer[count_next].tag   = found->tag;
+				++count_next;
+			}
+
+			++member;
+		}
+
+		if (count_next == 0u)
+			return starts; /* all remaining starts found */
+
+		swap	    = layer;
+		layer	    = next_layer;
+		next_layer  = swap;
+		count_layer = count_next;
+	}
+
+	/* remaining starts were pinned when the cache was last flushed */
+	for (pinned = run->pinned; pinned < run->pinned_until; ++pinned) {
+		found = lazy_layer_find(layer,
+					layer + count_layer,
+					pinned->state);
+		if (found != NULL_POINTER) {
+			starts->from  = pinned->from;
+			starts->state = found->tag;
+			++starts;
+		}
+	}
+
+	return starts;
+}
+
+/* close matches of all accepting rows in 'row' with no step on 'token' (or
+ * all accepting rows if at end of string) */
+static inline void
+lazy_close_matches(struct TastyLazyRun *const restrict run,
+		   const uint32_t row,
+		   const size_t until,
+		   const int at_end)
+{
+	const uint32_t *restrict member;
+	const uint32_t *restrict member_until;
+	struct TastyLazyStart *restrict start;
+	struct TastyLazyStart *restrict starts_until;
+	uint32_t count_set;
+	uint32_t count_layer;
+
+	struct TastyLazyTag *const restrict layer = run->layers[0];
+
+	member = lazy_cache_members(&run->cache,
+				    row,
+				    &count_set);
+	member_until = member + count_set;
+	count_layer  = 0u;
+
+	while (member < member_until) {
+		if (   (*member & TASTY_STATE_ACCEPTING)
+		    && (   at_end
+			|| (state_step(run->regex->states,
+				       *member,
+				       run->regex->classes[run->string[until]])
+			    == 0u))) {
+			layer[count_layer].state = *member;
+			layer[count_layer].tag	 = *member;
+			++count_layer;
+		}
+
+		++member;
+	}
+
+	starts_until = lazy_walk_back(run,
+				      layer,
+				      count_layer,
+				      until,
+				      run->starts);
+
+	for (start = run->starts; start < starts_until; ++start)
+		push_match(&run->match_alloc,
+			   start->from,
+			   run->string + until);
+}
+
+/* discard all cached sets, pinning running starts to their current rows */
+static inline int
+lazy_flush(struct TastyLazyRun *const restrict run,
+	   const size_t position)
+{
+	const uint32_t *restrict member;
+	struct TastyLazyStart *restrict pinned;
+	uint32_t count_set;
+	uint32_t count_layer;
+
+	/* give up if flushing fails to keep pace with the walk */
+	if (  (position - run->floor)
+	    < (((size_t) run->cache.capacity_rows) * TASTY_LAZY_FLUSH_MIN))
+		return TASTY_LAZY_GIVE_UP;
+
+	if (run->pinned_block == NULL_POINTER) {
+		run->pinned_block = malloc(sizeof(struct TastyLazyStart)
+					   * run->length_string
+					   * 2u);
+
+		if (UNLIKELY(run->pinned_block == NULL_POINTER))
+			return TASTY_ERROR_OUT_OF_MEMORY;
+
+		run->pinned	  = run->pinned_block;
+		run->pinned_until = run->pinned_block;
+	}
+
+	pinned = (run->pinned == run->pinned_block)
+	       ? (run->pinned_block + run->length_string)
+	       : run->pinned_block;
+
+	/* tag every occupied row with itself and walk back to current floor */
+	struct TastyLazyTag *const restrict layer = run->layers[0];
+
+	member = lazy_cache_members(&run->cache,
+				    run->trace[position],
+				    &count_set);
+
+	for (count_layer = 0u; count_layer < count_set; ++count_layer) {
+		run->set[count_layer]	 = member[count_layer];
+		layer[count_layer].state = member[count_layer];
+		layer[count_layer].tag	 = member[count_layer];
+	}
+
+	run->pinned_until = lazy_walk_back(run,
+					   layer,
+					   count_layer,
+					   position,
+					   pinned);
+	run->pinned	  = pinned;
+	run->floor	  = position;
+
+	/* restart cache from the current set */
+	lazy_cache_clear(&run->cache);
+
+	run->trace[position] = lazy_cache_intern(&run->cache,
+						 run->set,
+						 count_set);
+	return 0;
+}
+
+/* determinize transition from set occupied at 'position' on 'token' */
+static inline int
+lazy_transition(struct TastyLazyRun *const restrict run,
+		const size_t position,
+		const unsigned int token,
+		uint32_t *const restrict next)
+{
+	const uint32_t *restrict member;
+	const uint32_t *restrict member_until;
+	uint32_t count_set;
+	uint32_t count_next;
+	uint32_t emit;
+	uint32_t state;
+	uint32_t row;
+	int status;
+
+	const uint32_t *const restrict states = run->regex->states;
+
+	member = lazy_cache_members(&run->cache,
+				    run->trace[position],
+				    &count_set);
+	member_until = member + count_set;
+	count_next   = 0u;
+	emit	     = 0u;
+
+	while (member < member_until) {
+		state = state_step(states,
+				   *member,
+				   token);
+
+		if (state != 0u) {
+			if (count_next == run->cache.capacity_members)
+				return TASTY_LAZY_GIVE_UP;
+
+			count_next = lazy_set_insert(run->set,
+						     count_next,
+						     state);
+
+		} else if (*member & TASTY_STATE_ACCEPTING) {
+			emit = TASTY_LAZY_EMIT;
+		}
+
+		++member;
+	}
+
+	state = state_step(states,
+			   run->regex->initial,
+			   token);
+
+	if (state != 0u) {
+		if (count_next == run->cache.capacity_members)
+			return TASTY_LAZY_GIVE_UP;
+
+		count_next = lazy_set_insert(run->set,
+					     count_next,
+					     state);
+	}
+
+	row = lazy_cache_intern(&run->cache,
+				run->set,
+				count_next);
+
+	if (row == TASTY_LAZY_UNKNOWN) {
+		/* preserve successor, flushing reuses 'set' */
+		(void) memcpy(run->set + run->cache.capacity_members,
+			      run->set,
+			      sizeof(uint32_t) * count_next);
+
+		status = lazy_flush(run,
+				    position);
+		if (status != 0)
+			return status;
+
+		row = lazy_cache_intern(&run->cache,
+					run->set + run->cache.capacity_members,
+					count_next);
+
+		if (row == TASTY_LAZY_UNKNOWN)
+			return TASTY_LAZY_GIVE_UP;
+	}
+
+	*next = row | emit;
+
+	run->cache.rows[run->trace[position] + token] = *next;
+
+	return 0;
+}
+
+
+static inline void
+lazy_run_free(struct TastyLazyRun *const restrict run)
+{
+	free(run->cache.rows);
+	free(run->trace);
+	free(run->set);
+	free(run->starts);
+	free(run->pinned_block);
+}
+
+
+/* streaming
+ * ──────────────────────────────────────────────────────────────────────────
+ * Accumulators outlive the chunk that started them, so they record absolute
+ * offsets and are drawn from slabs recycled through a free list: memory
+ * tracks the number of matches still running, not the length of the stream.
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline struct TastyStreamAccumulator *
+stream_acc_pop(struct TastyStream *const restrict stream)
+{
+	struct TastyStreamAccumulator *restrict acc;
+	struct TastyStreamAccumulator *restrict acc_until;
+
+	if (stream->acc_free == NULL_POINTER) {
+		struct TastyStreamSlab *const restrict slab
+		= malloc(sizeof(struct TastyStreamSlab));
+
+		if (UNLIKELY(slab == NULL_POINTER))
+			return NULL_POINTER;
+
+		slab->next    = stream->slabs;
+		stream->slabs = slab;
+
+		/* thread slab onto free list */
+		acc	  = &slab->accumulators[0];
+		acc_until = acc + TASTY_STREAM_SLAB_LENGTH - 1l;
+
+		for (; acc < acc_until; ++acc)
+			acc->next = acc + 1l;
+
+		acc->next	 = NULL_POINTER;
+		stream->acc_free = &slab->accumulators[0];
+	}
+
+	acc		 = stream->acc_free;
+	stream->acc_free = acc->next;
+
+	return acc;
+}
+
+static inline int
+stream_reserve_matches(struct TastyStream *const restrict stream,
+		       const size_t count_matches)
+{
+	size_t capacity;
+
+	if (count_matches <= stream->capacity_matches)
+		return 0;
+
+	capacity = stream->capacity_matches * 2l;
+
+	if (capacity < count_matches)
+		capacity = count_matches;
+
+	struct TastyStreamMatch *const restrict matches
+	= malloc(sizeof(struct TastyStreamMatch) * capacity);
+
+	if (UNLIKELY(matches == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	free(stream->matches);
+
+	stream->matches		 = matches;
+	stream->capacity_matches = capacity;
+
+	return 0;
+}
+
+static inline void
+stream_free_slabs(struct TastyStream *const restrict stream)
+{
+	struct TastyStreamSlab *restrict slab;
+	struct TastyStreamSlab *restrict next_slab;
+
+	for (slab = stream->slabs; slab != NULL_POINTER; slab = next_slab) {
+		next_slab = slab->next;
+		free(slab);
+	}
+
+	stream->slabs	 = NULL_POINTER;
+	stream->acc_list = NULL_POINTER;
+	stream->acc_free = NULL_POINTER;
+}
+
+
+/* leftmost-longest
+ * ──────────────────────────────────────────────────────────────────────────
+ * Of the matches closed so far, keep the greedy chain taking the match of
+ * least start, then the next starting at or after its end, and so on.  A
+ * closing match ends at or after all of those in the chain, so one starting
+ * earlier than some in the chain displaces them (they overlap it), and the
+ * chain ahead of it is left as is.  A start overlapped by a match of the
+ * chain stays overlapped, as any match displacing it starts earlier and ends
+ * later.  Accumulators meeting in a row close together, so only the least
+ * start not yet overlapped is kept.
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline bool
+chain_overlaps(const struct TastyMatch *const restrict chain_from,
+	       const struct TastyMatch *restrict last,
+	       const unsigned char *const restrict from)
+{
+	while ((last > chain_from) && (last[-1].from >= (const char *) from))
+		--last;
+
+	return (last > chain_from) && (last[-1].until > (const char *) from);
+}
+
+static inline void
+claim_row(const struct TastyMatch *const restrict chain_from,
+	  const struct TastyMatch *const restrict chain_until,
+	  struct TastyAccumulator *const restrict occupant,
+	  const unsigned char *const restrict from)
+{
+	const unsigned char *restrict least;
+	const unsigned char *restrict other;
+
+	if (from < occupant->match_from) {
+		least = from;
+		other = occupant->match_from;
+	} else {
+		least = occupant->match_from;
+		other = from;
+	}
+
+	occupant->match_from = chain_overlaps(chain_from,
+					      chain_until,
+					      least)
+			     ? other
+			     : least;
+}
+
+static inline void
+chain_match(struct TastyMatch *const restrict chain_from,
+	    struct TastyMatch *restrict *const restrict match_alloc,
+	    const unsigned char *const restrict from,
+	    const unsigned char *const restrict until)
+{
+	struct TastyMatch *restrict last;
+
+	/* skip matches of later start, they overlap [from, until) */
+	last = *match_alloc;
+
+	while ((last > chain_from) && (last[-1].from > (const char *) from))
+		--last;
+
+	/* overlaps match of earlier start, chain unchanged */
+	if ((last > chain_from) && (last[-1].until > (const char *) from))
+		return;
+
+	*match_alloc = last;
+
+	push_match(match_alloc,
+		   from,
+		   until);
+}
+
+static inline void
+walk_leftmost_longest(const struct TastyRegex *const restrict regex,
+		      struct TastyMatchInterval *const restrict matches,
+		      struct TastyMatch *restrict match_alloc,
+		      struct TastyAccumulator *restrict acc_alloc,
+		      struct TastyAccumulator **const restrict occupants,
+		      const unsigned char *restrict string,
+		      const size_t length_string)
+{
+	struct TastyAccumulator *restrict acc_list; /* running, 1 per row */
+	struct TastyAccumulator *restrict *restrict acc_end;
+	struct TastyAccumulator *restrict *restrict acc_ptr;
+	struct TastyAccumulator *restrict acc_free;
+	struct TastyAccumulator *restrict acc;
+	struct TastyAccumulator *restrict occupant;
+	uint32_t next_state;
+	uint32_t accepting;
+	unsigned int token;
+
+	const uint32_t *const restrict states	    = regex->states;
+	const unsigned char *const restrict classes = &regex->classes[0];
+	const unsigned char *const restrict string_until = string
+							 + length_string;
+	const unsigned char *restrict hit = NULL_POINTER;
+
+	const bool has_inner  = (regex->length_inner > 0u);
+	const bool has_anchor = ((regex->anchors & TASTY_ANCHOR_START) != 0u);
+
+	const unsigned char *const restrict string_from = string;
+
+	acc_list      = NULL_POINTER;
+	acc_end	      = &acc_list;
+	acc_free      = NULL_POINTER;
+	matches->from = match_alloc;
+
+	/* walk string */
+	while (1) {
+		/* nothing accumulating: jump to next candidate start */
+		if (acc_list == NULL_POINTER) {
+			if (has_inner)
+				string = skip_to_candidate(regex,
+							   string,
+							   string_until,
+							   &hit);
+
+			if (regex->has_start_set)
+				string = scan_start_set(regex,
+							string,
+							string_until);
+
+			if (has_anchor)
+				string = skip_to_anchor(regex,
+							string_from,
+							string,
+							string_until);
+
+			if (string == string_until)
+				break;
+		}
+
+		/* push next acc unless its row is occupied */
+		next_state = anchor_allows_start(regex,
+						 string_from,
+						 string)
+			   ? state_step(states,
+					regex->initial,
+					classes[*string])
+			   : 0u;
+
+		occupant = occupants[next_state & TASTY_STATE_OFFSET];
+
+		if ((next_state != 0u) && (occupant != NULL_POINTER)) {
+			claim_row(matches->from,
+				  match_alloc,
+				  occupant,
+				  string);
+
+		} else if (next_state != 0u) {
+			if (acc_free != NULL_POINTER) {
+				acc	 = acc_free;
+				acc_free = acc->next;
+			} else {
+				acc = acc_alloc;
+				++acc_alloc;
+			}
+
+			acc->next	= NULL_POINTER;
+			acc->match_from = string;
+			acc->state	= next_state;
+
+			*acc_end = acc;
+			acc_end	 = &acc->next;
+		}
+
+		/* vacate rows for next step */
+		for (acc = acc_list; acc != NULL_POINTER; acc = acc->next)
+			occupants[acc->state & TASTY_STATE_OFFSET] = NULL_POINTER;
+
+		++string;
+
+		if (string == string_until)
+			break;
+
+		token	  = classes[*string];
+		accepting = anchor_accepting(regex,
+					     string,
+					     string_until);
+		acc_ptr	  = &acc_list;
+
+		/* step accs, the first into a row occupies it */
+		while ((acc = *acc_ptr) != NULL_POINTER) {
+			next_state = state_step(states,
+						acc->state,
+						token);
+
+			if (next_state != 0u) {
+				occupant = occupants[next_state
+						     & TASTY_STATE_OFFSET];
+
+				if (occupant == NULL_POINTER) {
+					occupants[next_state
+						  & TASTY_STATE_OFFSET] = acc;
+					acc->state = next_state;
+
+					acc_ptr = &acc->next;
+					continue;
+				}
+
+				/* meets occupant, keep 1 start for both */
+				claim_row(matches->from,
+					  match_alloc,
+					  occupant,
+					  acc->match_from);
+			}
+
+			/* remove acc from list */
+			*acc_ptr = acc->next;
+
+			/* if skipping reaches end of regex, offer match */
+			if ((next_state == 0u) && (acc->state & accepting))
+				chain_match(matches->from,
+					    &match_alloc,
+					    acc->match_from,
+					    string);
+
+			acc->next = acc_free;
+			acc_free  = acc;
+		}
+
+		acc_end = acc_ptr;
+	}
+
+	/* offer matches of accs left in accepting rows */
+	for (acc = acc_list; acc != NULL_POINTER; acc = acc->next)
+		if (acc->state & TASTY_STATE_ACCEPTING)
+			chain_match(matches->from,
+				    &match_alloc,
+				    acc->match_from,
+				    string_until);
+
+	/* close match interval */
+	matches->until = match_alloc;
+}
+
+
+/* earliest
+ * ──────────────────────────────────────────────────────────────────────────
+ * A match is reported as soon as any accumulator enters an accepting row,
+ * from the least start doing so, and every running accumulator is then
+ * dropped, as all overlap it.  Older accumulators are stepped first and keep
+ * the rows they enter, so those meeting them there are dropped at once.
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+walk_earliest(const struct TastyRegex *const restrict regex,
+	      struct TastyMatchInterval *const restrict matches,
+	      struct TastyMatch *restrict match_alloc,
+	      struct TastyAccumulator *restrict acc_alloc,
+	      struct TastyAccumulator **const restrict occupants,
+	      const unsigned char *restrict string,
+	      const size_t length_string)
+{
+	struct TastyAccumulator *restrict acc_list; /* running, oldest first */
+	struct TastyAccumulator *restrict *restrict acc_ptr;
+	struct TastyAccumulator *restrict acc_free;
+	struct TastyAccumulator *restrict acc;
+	const unsigned char *restrict match_from;
+	uint32_t next_state;
+	uint32_t accepting;
+	unsigned int token;
+
+	const uint32_t *const restrict states	    = regex->states;
+	const unsigned char *const restrict classes = &regex->classes[0];
+	const unsigned char *const restrict string_until = string
+							 + length_string;
+	const unsigned char *restrict hit = NULL_POINTER;
+
+	const bool has_inner  = (regex->length_inner > 0u);
+	const bool has_anchor = ((regex->anchors & TASTY_ANCHOR_START) != 0u);
+
+	const unsigned char *const restrict string_from = string;
+
+	acc_list      = NULL_POINTER;
+	acc_free      = NULL_POINTER;
+	matches->from = match_alloc;
+
+	/* walk string */
+	while (1) {
+		/* nothing accumulating: jump to next candidate start */
+		if (acc_list == NULL_POINTER) {
+			if (has_inner)
+				string = skip_to_candidate(regex,
+							   string,
+							   string_until,
+							   &hit);
+
+			if (regex->has_start_set)
+				string = scan_start_set(regex,
+							string,
+							string_until);
+
+			if (has_anchor)
+				string = skip_to_anchor(regex,
+							string_from,
+							string,
+							string_until);
+
+			if (string == string_until)
+				break;
+		}
+
+		token	   = classes[*string];
+		accepting  = anchor_accepting(regex,
+					      string + 1,
+					      string_until);
+		acc_ptr	   = &acc_list;
+		match_from = NULL_POINTER;
+
+		/* step accs, the oldest into a row occupies it */
+		while ((acc = *acc_ptr) != NULL_POINTER) {
+			next_state = state_step(states,
+						acc->state,
+						token);
+
+			if (   (next_state != 0u)
+			    && (occupants[next_state & TASTY_STATE_OFFSET]
+				== NULL_POINTER)) {
+				occupants[next_state & TASTY_STATE_OFFSET] = acc;
+				acc->state = next_state;
+
+				/* oldest accepting acc has least start */
+				if (   (match_from == NULL_POINTER)
+				    && (next_state & accepting))
+					match_from = acc->match_from;
+
+				acc_ptr = &acc->next;
+				continue;
+			}
+
+			/* remove acc from list */
+			*acc_ptr = acc->next;
+
+			acc->next = acc_free;
+			acc_free  = acc;
+		}
+
+		/* push next acc unless its row is occupied */
+		next_state = anchor_allows_start(regex,
+						 string_from,
+						 string)
+			   ? state_step(states,
+					regex->initial,
+					token)
+			   : 0u;
+
+		if (   (next_state != 0u)
+		    && (occupants[next_state & TASTY_STATE_OFFSET]
+			== NULL_POINTER)) {
+			if (acc_free != NULL_POINTER) {
+				acc	 = acc_free;
+				acc_free = acc->next;
+			} else {
+				acc = acc_alloc;
+				++acc_alloc;
+			}
+
+			acc->next	= NULL_POINTER;
+			acc->match_from = string;
+			acc->state	= next_state;
+
+			*acc_ptr = acc;
+
+			if (   (match_from == NULL_POINTER)
+			    && (next_state & accepting))
+				match_from = string;
+		}
+
+		/* vacate rows for next step */
+		for (acc = acc_list; acc != NULL_POINTER; acc = acc->next)
+			occupants[acc->state & TASTY_STATE_OFFSET] = NULL_POINTER;
+
+		++string;
+
+		/* report match, dropping all accs overlapping it */
+		if (match_from != NULL_POINTER) {
+			push_match(&match_alloc,
+				   match_from,
+				   string);
+
+			while ((acc = acc_list) != NULL_POINTER) {
+				acc_list  = acc->next;
+				acc->next = acc_free;
+				acc_free  = acc;
+			}
+		}
+
+		if (string == string_until)
+			break;
+	}
+
+	/* close match interval */
+	matches->until = match_alloc;
+}
+
+
+/* API
+ * ────────────────────────────────────────────────────────────────────────── */
+static inline void
+walk_accumulators(const struct TastyRegex *const restrict regex,
+		  struct TastyMatchInterval *const restrict matches,
+		  struct TastyMatch *restrict match_alloc,
+		  struct TastyAccumulator *restrict acc_alloc,
+		  const unsigned char *restrict string,
+		  const size_t length_string)
+{
+	struct TastyAccumulator *restrict acc_list;
+
+	if (regex->row_steps != NULL_POINTER) {
+		matches->from = match_alloc;
+
+		(void) walk_row_set(regex,
+				    string,
+				    length_string,
+				    &append_match,
+				    (void *) &match_alloc);
+
+		matches->until = match_alloc;
+		return;
+	}
+
+	const unsigned char *const restrict classes = &regex->classes[0];
+	const unsigned char *const restrict string_until = string
+							 + length_string;
+
+	acc_list  = NULL_POINTER;	/* initialize acc_list to empty */
+	matches->from = match_alloc;	/* set start of match interval */
+
+	const unsigned char *restrict hit = NULL_POINTER;
+
+	const bool has_inner  = (regex->length_inner > 0u);
+	const bool has_anchor = ((regex->anchors & TASTY_ANCHOR_START) != 0u);
+
+	const unsigned char *const restrict string_from = string;
+
+	/* walk string */
+	while (1) {
+		/* nothing accumulating: jump to next candidate start */
+		if (acc_list == NULL_POINTER) {
+			if (has_inner)
+				string = skip_to_candidate(regex,
+							   string,
+							   string_until,
+							   &hit);
+
+			if (regex->has_start_set)
+				string = scan_start_set(regex,
+							string,
+							string_until);
+
+			if (has_anchor)
+				string = skip_to_anchor(regex,
+							string_from,
+							string,
+							string_until);
+
+			if (string == string_until)
+				break;
+		}
+
+		/* push next acc if explicit start of match found */
+		if (anchor_allows_start(regex,
+					string_from,
+					string))
+			push_next_acc(&acc_list,
+				      &acc_alloc,
+				      regex,
+				      string,
+				      classes[*string]);
+
+		++string;
+
+		if (string == string_until)
+			break;
+
+		/* traverse acc_list: update states, prune dead-end accs, and
+		 * append matches */
+		acc_list_process(&acc_list,
+				 &match_alloc,
+				 regex->states,
+				 string,
+				 classes[*string],
+				 anchor_accepting(regex,
+						  string,
+						  string_until));
+	}
+
+	/* append matches found in acc_list */
+	acc_list_final_scan(acc_list,
+			    &match_alloc,
+			    string);
+
+	/* close match interval */
+	matches->until = match_alloc;
+}
+
+static inline int
+run_accumulators(const struct TastyRegex *const restrict regex,
+		 struct TastyMatchInterval *const restrict matches,
+		 const unsigned char *restrict string,
+		 const size_t length_string)
+{
+	/* at most N matches */
+	struct TastyMatch *const restrict match_alloc
+	= malloc(sizeof(struct TastyMatch) * length_string);
+
+	if (UNLIKELY(match_alloc == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	struct TastyAccumulator *restrict accumulators = NULL_POINTER;
+
+	/* at most N running accumulators, none for row set walk */
+	if (regex->row_steps == NULL_POINTER) {
+		accumulators = malloc(sizeof(struct TastyAccumulator)
+				      * length_string);
+
+		if (UNLIKELY(accumulators == NULL_POINTER)) {
+			free(match_alloc);
+			return TASTY_ERROR_OUT_OF_MEMORY;
+		}
+	}
+
+	walk_accumulators(regex,
+			  matches,
+			  match_alloc,
+			  accumulators,
+			  string,
+			  length_string);
+
+	/* free temporary storage */
+	free(accumulators);
+
+	/* return success */
+	return 0;
+}
+
+static inline int
+run_non_overlapping(const struct TastyRegex *const restrict regex,
+		    struct TastyMatchInterval *const restrict matches,
+		    const unsigned char *restrict string,
+		    const size_t length_string,
+		    const unsigned int mode)
+{
+	/* at most N matches */
+	struct TastyMatch *const restrict match_alloc
+	= malloc(sizeof(struct TastyMatch) * length_string);
+
+	if (UNLIKELY(match_alloc == NULL_POINTER))
+		return TASTY_ERROR_OUT_OF_MEMORY;
+
+	/* at most 1 running accumulator per row, and an occupant per row */
+	const size_t count_accumulators = (length_string < regex->length_states)
+					? length_string
+					: regex->length_states;
+
+	struct TastyAccumulator *const restrict accumulators
+	= malloc(sizeof(struct TastyAccumulator) * count_accumulators);
+
+	struct TastyAccumulator **const restrict occupants
+	= calloc(regex->length_states,
+		 sizeof(struct TastyAccumulator *));
+
+	if (UNLIKELY(   (accumulators == NULL_POINTER)
+		     || (occupants == NULL_POINTER))) {
+		free(occupants);
+		free(accumulators);
+		free(match_alloc);
+		return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	if (mode == TASTY_MATCH_EARLIEST)
+		walk_earliest(regex,
+			      matches,
+			      match_alloc,
+			      accumulators,
+			      occupants,
+			      string,
+			      length_string);
+	else
+		walk_leftmost_longest(regex,
+				      matches,
+				      match_alloc,
+				      accumulators,
+				      occupants,
+				      string,
+				      length_string);
+
+	/* free temporary storage */
+	free(occupants);
+	free(accumulators);
+
+	return 0;
+}
+
+/* (re)allocate storage of 'context' to hold at least 'capacity' matches and
+ * accumulators, discarding prior contents */
+static inline int
+run_context_reserve(struct TastyRunContext *const restrict context,
+		    const size_t capacity)
+{
+	free(context->matches);
+
+	context->matches = malloc((  sizeof(struct TastyMatch)
+				   + sizeof(struct TastyAccumulator))
+				  * capacity);
+
+	if (UNLIKELY(context->matches == NULL_POINTER)) {
+		context->accumulators = NULL_POINTER;
+		context->capacity     = 0l;
+		return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	/* accumulators follow matches in the same block */
+	context->accumulators = (struct TastyAccumulator *)
+				(context->matches + capacity);
+	context->capacity     = capacity;
+
+	return 0;
+}
+
+
+int
+tasty_regex_run(const struct TastyRegex *const restrict regex,
+		struct TastyMatchInterval *const restrict matches,
+		const char *restrict string)
+{
+	/* want to ensure at least 1 non-'\0' char before start of walk */
+	if (*string == '\0') {
+		matches->from  = NULL_POINTER;
+		matches->until = NULL_POINTER;
+		return 0;
+	}
+
+	return run_accumulators(regex,
+				matches,
+				(const unsigned char *) string,
+				nonempty_string_length(string));
+}
+
+int
+tasty_regex_run_n(const struct TastyRegex *const restrict regex,
+		  struct TastyMatchInterval *const restrict matches,
+		  const char *restrict data,
+		  const size_t length)
+{
+	/* want to ensure at least 1 byte before start of walk */
+	if (length == 0l) {
+		matches->from  = NULL_POINTER;
+		matches->until = NULL_POINTER;
+		return 0;
+	}
+
+	return run_accumulators(regex,
+				matches,
+				(const unsigned char *) data,
+				length);
+}
+
+int
+tasty_regex_run_callback(const struct TastyRegex *const restrict regex,
+			 const char *restrict data,
+			 const size_t length,
+			 const TastyMatchCallback callback,
+			 void *const user)
+{
+	/* want to ensure at least 1 byte before start of walk */
+	if (length == 0l)
+		return 0;
+
+	struct TastyAccumulator *restrict accumulators = NULL_POINTER;
+
+	/* at most N running accumulators, no match storage, none for row set
+	 * walk */
+	if (regex->row_steps == NULL_POINTER) {
+		accumulators = malloc(sizeof(struct TastyAccumulator) * length);
+
+		if (UNLIKELY(accumulators == NULL_POINTER))
+			return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	const int status = walk_callback(regex,
+					 accumulators,
+					 (const unsigned char *) data,
+					 length,
+					 callback,
+					 user);
+
+	/* free temporary storage */
+	free(accumulators);
+
+	return status;
+}
+
+int
+tasty_regex_test(const struct TastyRegex *const restrict regex,
+		 const char *restrict data,
+		 const size_t length,
+		 bool *const restrict is_match)
+{
+	*is_match = false;
+
+	if (length == 0l)
+		return 0;
+
+	struct TastyAccumulator *restrict accumulators = NULL_POINTER;
+
+	if (regex->row_steps == NULL_POINTER) {
+		accumulators = malloc(sizeof(struct TastyAccumulator) * length);
+
+		if (UNLIKELY(accumulators == NULL_POINTER))
+			return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	/* stop at first match closed */
+	*is_match = (walk_callback(regex,
+				   accumulators,
+				   (const unsigned char *) data,
+				   length,
+				   &stop_at_match,
+				   NULL_POINTER) != 0);
+
+	free(accumulators);
+
+	return 0;
+}
+
+int
+tasty_regex_count(const struct TastyRegex *const restrict regex,
+		  const char *restrict data,
+		  const size_t length,
+		  size_t *const restrict count_matches)
+{
+	*count_matches = 0l;
+
+	if (length == 0l)
+		return 0;
+
+	struct TastyAccumulator *restrict accumulators = NULL_POINTER;
+
+	if (regex->row_steps == NULL_POINTER) {
+		accumulators = malloc(sizeof(struct TastyAccumulator) * length);
+
+		if (UNLIKELY(accumulators == NULL_POINTER))
+			return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	(void) walk_callback(regex,
+			     accumulators,
+			     (const unsigned char *) data,
+			     length,
+			     &count_match,
+			     count_matches);
+
+	free(accumulators);
+
+	return 0;
+}
+
+int
+tasty_regex_run_mode(const struct TastyRegex *const restrict regex,
+		     struct TastyMatchInterval *const restrict matches,
+		     const char *restrict data,
+		     const size_t length,
+		     const unsigned int mode)
+{
+	if (length == 0l) {
+		matches->from  = NULL_POINTER;
+		matches->until = NULL_POINTER;
+		return 0;
+	}
+
+	switch (mode) {
+	case TASTY_MATCH_LEFTMOST_LONGEST:
+	case TASTY_MATCH_EARLIEST:
+		return run_non_overlapping(regex,
+					   matches,
+					   (const unsigned char *) data,
+					   length,
+					   mode);
+
+	default: /* TASTY_MATCH_ALL */
+		return run_accumulators(regex,
+					matches,
+					(const unsigned char *) data,
+					length);
+	}
+}
+
+int
+tasty_regex_run_context(const struct TastyRegex *const restrict regex,
+			struct TastyRunContext *const restrict context,
+			struct TastyMatchInterval *const restrict matches,
+			const char *restrict data,
+			const size_t length)
+{
+	size_t capacity;
+	int status;
+
+	/* want to ensure at least 1 byte before start of walk */
+	if (length == 0l) {
+		matches->from  = NULL_POINTER;
+		matches->until = NULL_POINTER;
+		return 0;
+	}
+
+	/* grow geometrically, so that storage settles after a few calls */
+	if (length > context->capacity) {
+		capacity = context->capacity * 2l;
+
+		if (capacity < length)
+			capacity = length;
+
+		status = run_context_reserve(context,
+					     capacity);
+		if (status != 0)
+			return status;
+	}
+
+	walk_accumulators(regex,
+			  matches,
+			  context->matches,
+			  context->accumulators,
+			  (const unsigned char *) data,
+			  length);
+
+	return 0;
+}
+
+int
+tasty_run_context_create(struct TastyRunContext *const restrict context,
+			 const size_t length_hint)
+{
+	context->matches	   = NULL_POINTER;
+	context->accumulators	   = NULL_POINTER;
+	context->capacity	   = 0l;
+	context->capacity_reserved = length_hint;
+
+	if (length_hint == 0l)
+		return 0;
+
+	return run_context_reserve(context,
+				   length_hint);
+}
+
+void
+tasty_run_context_reset(struct TastyRunContext *const restrict context)
+{
+	/* release storage grown past the reserved capacity */
+	if (context->capacity <= context->capacity_reserved)
+		return;
+
+	if (context->capacity_reserved == 0l) {
+		tasty_run_context_destroy(context);
+		return;
+	}
+
+	/* on failure context is left empty and regrows on next run */
+	(void) run_context_reserve(context,
+				   context->capacity_reserved);
+}
+
+void
+tasty_run_context_destroy(struct TastyRunContext *const restrict context)
+{
+	free(context->matches);
+
+	context->matches      = NULL_POINTER;
+	context->accumulators = NULL_POINTER;
+	context->capacity     = 0l;
+}
+
+void
+tasty_stream_begin(struct TastyStream *const restrict stream,
+		   const struct TastyRegex *const restrict regex)
+{
+	stream->regex		 = regex;
+	stream->acc_list	 = NULL_POINTER;
+	stream->acc_free	 = NULL_POINTER;
+	stream->slabs		 = NULL_POINTER;
+	stream->matches		 = NULL_POINTER;
+	stream->capacity_matches = 0l;
+	stream->count_running	 = 0l;
+	stream->offset		 = 0l;
+	stream->at_line_start	 = true;
+}
+
+int
+tasty_stream_feed(struct TastyStream *const restrict stream,
+		  const char *restrict data,
+		  const size_t length,
+		  struct TastyStreamMatchInterval *const restrict matches)
+{
+	struct TastyStreamAccumulator *restrict *restrict acc_ptr;
+	struct TastyStreamAccumulator *restrict acc;
+	struct TastyStreamMatch *restrict match_alloc;
+	uint32_t next_state;
+	uint32_t accepting;
+	unsigned int token;
+	int status;
+
+	/* every running and newly started accumulator closes at most once */
+	status = stream_reserve_matches(stream,
+					stream->count_running + length);
+	if (status != 0)
+		return status;
+
+	const struct TastyRegex *const restrict regex = stream->regex;
+	const uint32_t *const restrict states	      = regex->states;
+	const char *const restrict data_until	      = data + length;
+
+	/* closing before '\n' (TASTY_ANCHOR_LINES), or only at stream end */
+	const uint32_t accepting_line  = (regex->anchors & TASTY_ANCHOR_LINES)
+				       ? TASTY_STATE_ACCEPTING
+				       : 0u;
+	const uint32_t accepting_other = (regex->anchors & TASTY_ANCHOR_END)
+				       ? 0u
+				       : TASTY_STATE_ACCEPTING;
+	const bool has_anchor = ((regex->anchors & TASTY_ANCHOR_START) != 0u);
+
+	match_alloc   = stream->matches;
+	matches->from = match_alloc;
+
+	for (; data < data_until; ++data, ++(stream->offset)) {
+		token	  = regex->classes[(unsigned char) *data];
+		accepting = (*data == '\n')
+			  ? (accepting_line | accepting_other)
+			  : accepting_other;
+
+		/* update running accs, closing those that reach a dead end */
+		acc_ptr = &stream->acc_list;
+		acc	= *acc_ptr;
+
+		while (acc != NULL_POINTER) {
+			next_state = state_step(states,
+						acc->state,
+						token);
+
+			if (next_state != 0u) {
+				acc->state = next_state;
+
+				acc_ptr = &acc->next;
+				acc	= acc->next;
+				continue;
+			}
+
+			if (acc->state & accepting) {
+				match_alloc->from  = acc->match_from;
+				match_alloc->until = stream->offset;
+				++match_alloc;
+			}
+
+			/* unlink and recycle acc */
+			*acc_ptr	 = acc->next;
+			acc->next	 = stream->acc_free;
+			stream->acc_free = acc;
+			acc		 = *acc_ptr;
+			--(stream->count_running);
+		}
+
+		/* push next acc if explicit start of match found */
+		next_state = (   !has_anchor
+			      || (stream->offset == 0l)
+			      || (   (regex->anchors & TASTY_ANCHOR_LINES)
+				  && stream->at_line_start))
+			   ? state_step(states,
+					regex->initial,
+					token)
+			   : 0u;
+
+		stream->at_line_start = (*data == '\n');
+
+		if (next_state == 0u)
+			continue;
+
+		acc = stream_acc_pop(stream);
+
+		if (UNLIKELY(acc == NULL_POINTER)) {
+			status = TASTY_ERROR_OUT_OF_MEMORY;
+			break;
+		}
+
+		acc->state	 = next_state;
+		acc->match_from	 = stream->offset;
+		acc->next	 = stream->acc_list;
+		stream->acc_list = acc;
+		++(stream->count_running);
+	}
+
+	matches->until = match_alloc;
+
+	return status;
+}
+
+int
+tasty_stream_end(struct TastyStream *const restrict stream,
+		 struct TastyStreamMatchInterval *const restrict matches)
+{
+	struct TastyStreamAccumulator *restrict acc;
+	struct TastyStreamMatch *restrict match_alloc;
+	int status;
+
+	status = stream_reserve_matches(stream,
+					stream->count_running + 1l);
+
+	if (status == 0) {
+		match_alloc   = stream->matches;
+		matches->from = match_alloc;
+
+		/* close accs that may skip to end of regex */
+		for (acc = stream->acc_list;
+		     acc != NULL_POINTER;
+		     acc = acc->next) {
+			if (acc->state & TASTY_STATE_ACCEPTING) {
+				match_alloc->from  = acc->match_from;
+				match_alloc->until = stream->offset;
+				++match_alloc;
+			}
+		}
+
+		matches->until = match_alloc;
+
+	} else {
+		free(stream->matches);
+	}
+
+	/* match storage is handed over to caller */
+	stream_free_slabs(stream);
+	stream->matches		 = NULL_POINTER;
+	stream->capacity_matches = 0l;
+	stream->count_running	 = 0l;
+
+	return status;
+}
+
+int
+tasty_regex_run_lazy(const struct TastyRegex *const restrict regex,
+		     struct TastyMatchInterval *const restrict matches,
+		     const char *restrict string,
+		     const size_t cache_budget)
+{
+	struct TastyLazyRun run;
+	const uint32_t *restrict rows;
+	uint32_t next;
+	uint32_t row;
+	size_t position;
+	unsigned int token;
+	int status;
+
+	/* want to ensure at least 1 non-'\0' char before start of walk */
+	if (*string == '\0') {
+		matches->from  = NULL_POINTER;
+		matches->until = NULL_POINTER;
+		return 0;
+	}
+
+	run.regex	  = regex;
+	run.string	  = (const unsigned char *) string;
+	run.length_string = nonempty_string_length(string);
+
+	/* anchors tie steps to positions, sets of rows can't be cached */
+	if (regex->anchors & (TASTY_ANCHOR_START | TASTY_ANCHOR_END))
+		return run_accumulators(regex,
+					matches,
+					run.string,
+					run.length_string);
+
+	status = lazy_cache_init(&run.cache,
+				 cache_budget,
+				 regex->span);
+
+	if (status == TASTY_LAZY_GIVE_UP)
+		return run_accumulators(regex,
+					matches,
+					run.string,
+					run.length_string);
+	if (status != 0)
+		return status;
+
+	run.floor	  = 0u;
+	run.pinned_block  = NULL_POINTER;
+	run.pinned	  = NULL_POINTER;
+	run.pinned_until  = NULL_POINTER;
+
+	/* at most N matches */
+	struct TastyMatch *const restrict match_from
+	= malloc(sizeof(struct TastyMatch) * run.length_string);
+
+	run.match_alloc = match_from;
+	run.trace	= malloc(sizeof(uint32_t) * (run.length_string + 1u));
+	run.starts	= malloc(sizeof(struct TastyLazyStart)
+				 * run.length_string);
+	/* successor set + copy preserved across flush, 2 walk back layers */
+	run.set		= malloc((sizeof(uint32_t) * 2u
+				  + sizeof(struct TastyLazyTag) * 2u)
+				 * run.cache.capacity_members);
+
+	if (UNLIKELY(   (match_from == NULL_POINTER)
+		     || (run.trace  == NULL_POINTER)
+		     || (run.starts == NULL_POINTER)
+		     || (run.set    == NULL_POINTER))) {
+		free(match_from);
+		lazy_run_free(&run);
+		return TASTY_ERROR_OUT_OF_MEMORY;
+	}
+
+	run.layers[0] = (struct TastyLazyTag *)
+			(run.set + (run.cache.capacity_members * 2u));
+	run.layers[1] = run.layers[0] + run.cache.capacity_members;
+
+	const unsigned char *const restrict classes = &regex->classes[0];
+
+	/* begin walk from the empty set */
+	rows	     = run.cache.rows;
+	row	     = lazy_cache_intern(&run.cache,
+					 run.set,
+					 0u);
+	run.trace[0] = row;
+
+	/* walk string */
+	for (position = 0u; position < run.length_string; ++position) {
+		token = classes[run.string[position]];
+		next  = rows[row + token];
+
+		if (UNLIKELY(next == TASTY_LAZY_UNKNOWN)) {
+			status = lazy_transition(&run,
+						 position,
+						 token,
+						 &next);
+			if (status != 0)
+				break;
+		}
+
+		/* some running accumulators close on 'token' */
+		if (next & TASTY_LAZY_EMIT)
+			lazy_close_matches(&run,
+					   run.trace[position],
+					   position,
+					   0);
+
+		row			= next & TASTY_LAZY_ROW;
+		run.trace[position + 1] = row;
+	}
+
+	if (status == 0) {
+		/* append matches found in final set */
+		lazy_close_matches(&run,
+				   row,
+				   run.length_string,
+				   1);
+
+		matches->from  = match_from;
+		matches->until = run.match_alloc;
+
+	} else {
+		free(match_from);
+	}
+
+	/* free temporary storage */
+	lazy_run_free(&run);
+
+	/* cache thrashing, start over with accumulator walk */
+	if (status == TASTY_LAZY_GIVE_UP)
+		return run_accumulators(regex,
+					matches,
+					run.string,
+					run.length_string);
+
+	return status;
+}
+
+
+/* free allocations */
+extern inline void
+tasty_match_interval_free(struct TastyMatchInterval *const restrict matches);
+
+extern inline void
+tasty_stream_match_interval_free(struct TastyStreamMatchInterval *const restrict matches);
@@ -10,6 +10,18 @@ extern "C" {
 /* external dependencies
  * ────────────────────────────────────────────────────────────────────────── */
 #include "tasty_regex_globals.h" /* TastyState|Regex, m|calloc/free, ERROR* */
+#include <stdbool.h>		 /* bool */
+
+
+/* helper macros
+ * ────────────────────────────────────────────────────────────────────────── */
+/* match modes of tasty_regex_run_mode */
+#define TASTY_MATCH_ALL			0u /* every start, as tasty_regex_run */
+#define TASTY_MATCH_LEFTMOST_LONGEST	1u /* greedy per start, non-overlapping */
+#define TASTY_MATCH_EARLIEST		2u /* first accept, non-overlapping */
+
+/* default memory budget of state cache for tasty_regex_run_lazy (bytes) */
+#define TASTY_LAZY_BUDGET_DEFAULT (1u << 20)
 
 
 /* typedefs, struct declarations
@@ -26,6 +38,49 @@ struct TastyMatchInterval {
 	struct TastyMatch *restrict until;
 };
 
+/* called for each match as it is found, return nonzero to stop the run */
+typedef int
+(*TastyMatchCallback)(void *user,
+		      const struct TastyMatch *match);
+
+/* defines a match interval on a stream by absolute byte offsets:
+ * from ≤ offset < until */
+struct TastyStreamMatch {
+	size_t from;
+	size_t until;
+};
+
+/* defines an array of stream matches: from ≤ match < until */
+struct TastyStreamMatchInterval {
+	struct TastyStreamMatch *restrict from;
+	struct TastyStreamMatch *restrict until;
+};
+
+/* state of a match carried across chunks of a stream */
+struct TastyStreamAccumulator;
+struct TastyStreamSlab;
+struct TastyStream {
+	const struct TastyRegex *regex;
+	struct TastyStreamAccumulator *acc_list; /* running, newest first */
+	struct TastyStreamAccumulator *acc_free; /* recycled */
+	struct TastyStreamSlab *slabs;		 /* accumulator storage */
+	struct TastyStreamMatch *matches;	 /* matches closed last call */
+	size_t capacity_matches;
+	size_t count_running;			 /* length of acc_list */
+	size_t offset;				 /* count of bytes fed */
+	bool at_line_start;			 /* last byte fed was '\n' */
+};
+
+/* reusable match and accumulator storage for tasty_regex_run_context, grows
+ * to fit the longest input run */
+struct TastyAccumulator;
+struct TastyRunContext {
+	struct TastyMatch *matches;		/* 'capacity' matches */
+	struct TastyAccumulator *accumulators;	/* 'capacity' accumulators */
+	size_t capacity;			/* max input length w/o growing */
+	size_t capacity_reserved;		/* capacity kept across reset */
+};
+
 
 /* API
  * ────────────────────────────────────────────────────────────────────────── */
@@ -34,6 +89,90 @@ tasty_regex_run(const struct TastyRegex *const restrict regex,
 		struct TastyMatchInterval *const restrict matches,
 		const char *restrict string);
 
+/* match 'length' bytes of 'data', which need not be '\0'-terminated and may
+ * contain '\0' bytes */
+int
+tasty_regex_run_n(const struct TastyRegex *const restrict regex,
+		  struct TastyMatchInterval *const restrict matches,
+		  const char *restrict data,
+		  const size_t length);
+
+/* as tasty_regex_run_n, but matches are passed to 'callback' in order as
+ * they close rather than stored, returns nonzero value returned by
+ * 'callback' if stopped early */
+int
+tasty_regex_run_callback(const struct TastyRegex *const restrict regex,
+			 const char *restrict data,
+			 const size_t length,
+			 const TastyMatchCallback callback,
+			 void *const user);
+
+/* whether 'data' contains at least 1 match, stops at first match closed */
+int
+tasty_regex_test(const struct TastyRegex *const restrict regex,
+		 const char *restrict data,
+		 const size_t length,
+		 bool *const restrict is_match);
+
+/* count of matches tasty_regex_run_n would produce, without storing them */
+int
+tasty_regex_count(const struct TastyRegex *const restrict regex,
+		  const char *restrict data,
+		  const size_t length,
+		  size_t *const restrict count_matches);
+
+/* as tasty_regex_run_n, reporting matches per 'mode' (TASTY_MATCH_*) */
+int
+tasty_regex_run_mode(const struct TastyRegex *const restrict regex,
+		     struct TastyMatchInterval *const restrict matches,
+		     const char *restrict data,
+		     const size_t length,
+		     const unsigned int mode);
+
+/* as tasty_regex_run_n, but 'matches' refers to storage owned by 'context',
+ * valid until its next run, reset, or destroy (do not free 'matches') */
+int
+tasty_regex_run_context(const struct TastyRegex *const restrict regex,
+			struct TastyRunContext *const restrict context,
+			struct TastyMatchInterval *const restrict matches,
+			const char *restrict data,
+			const size_t length);
+
+int
+tasty_run_context_create(struct TastyRunContext *const restrict context,
+			 const size_t length_hint);
+
+void
+tasty_run_context_reset(struct TastyRunContext *const restrict context);
+
+void
+tasty_run_context_destroy(struct TastyRunContext *const restrict context);
+
+/* match a stream fed in chunks, matches spanning chunks are reported when
+ * they close with offsets relative to the start of the stream */
+void
+tasty_stream_begin(struct TastyStream *const restrict stream,
+		   const struct TastyRegex *const restrict regex);
+
+/* 'matches' closed within chunk, valid until next feed or end on 'stream' */
+int
+tasty_stream_feed(struct TastyStream *const restrict stream,
+		  const char *restrict data,
+		  const size_t length,
+		  struct TastyStreamMatchInterval *const restrict matches);
+
+/* 'matches' still running at end of stream, must be freed with
+ * tasty_stream_match_interval_free */
+int
+tasty_stream_end(struct TastyStream *const restrict stream,
+		 struct TastyStreamMatchInterval *const restrict matches);
+
+int
+tasty_regex_run_lazy(const struct TastyRegex *const restrict regex,
+		     struct TastyMatchInterval *const restrict matches,
+		     const char *restrict string,
+		     const size_t cache_budget);
+
 /* free allocations */
 inline void
 tasty_match_interval_free(struct TastyMatchInterval *const restrict matches)
@@ -41,6 +180,12 @@ tasty_match_interval_free(struct TastyMatchInterval *const restrict matches)
 	free((void *) matches->from);
 }
 
+inline void
+tasty_stream_match_interval_free(struct TastyStreamMatchInterval *const restrict matches)
+{
+	free((void *) matches->from);
+}
+
 #ifdef __cplusplus /* close 'extern "C" {' */
 }
 #endif /* ifdef __cplusplus */
@@ -1,6 +1,26 @@
 #include "unity.h"
 #include "tasty_regex.h"
 #include <unistd.h>
+#include <string.h>
+
+struct MatchCollector {
+	struct TastyMatch matches[8];
+	int count_matches;
+	int count_stop;
+};
+
+static int
+collect_match(void *user,
+	      const struct TastyMatch *match)
+{
+	struct MatchCollector *const restrict collector = user;
+
+	collector->matches[collector->count_matches] = *match;
+	++(collector->count_matches);
+
+	/* stop run once 'count_stop' matches are collected */
+	return (collector->count_matches == collector->count_stop) ? 42 : 0;
+}
 
 void
 setUp(void)
@@ -46,3 +66,1229 @@ test_tasty_regex(void)
 
 	tasty_match_interval_free(&matches);
 }
+
+void
+test_tasty_regex_run_lazy(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	struct TastyMatchInterval lazy_matches;
+	const char *const restrict string
+	= "oogity boogity boo, oogity boogity boo, oogity boogity boo";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "b?oo(gity)?"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+
+	/* default budget, then small enough to flush the state cache */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_lazy(&regex,
+						   &lazy_matches,
+						   string,
+						   TASTY_LAZY_BUDGET_DEFAULT));
+
+	TEST_ASSERT_EQUAL_INT(matches.until - matches.from,
+			      lazy_matches.until - lazy_matches.from);
+	TEST_ASSERT_EQUAL_MEMORY(matches.from,
+				 lazy_matches.from,
+				 sizeof(struct TastyMatch)
+				 * (matches.until - matches.from));
+
+	tasty_match_interval_free(&lazy_matches);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_lazy(&regex,
+						   &lazy_matches,
+						   string,
+						   256));
+
+	TEST_ASSERT_EQUAL_INT(matches.until - matches.from,
+			      lazy_matches.until - lazy_matches.from);
+	TEST_ASSERT_EQUAL_MEMORY(matches.from,
+				 lazy_matches.from,
+				 sizeof(struct TastyMatch)
+				 * (matches.until - matches.from));
+
+	tasty_match_interval_free(&lazy_matches);
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_compile_minimize(void)
+{
+	struct TastyRegex regex;
+	struct TastyRegex minimized;
+	struct TastyMatchInterval matches;
+	struct TastyMatchInterval minimized_matches;
+	/* rows that step but never match must not collapse into dead end */
+	const char *const restrict cases[][2] = {
+		{ "I (love|(dis)?like) (cat|dog)s",
+		  "I love cats, and I like dogs, but I dislike gophers" },
+		{ "c?(c+b+a|b+b?b)?",	 "bacbaaaabadb" },
+		{ "a*|(b+baa?)b+a.|cbcc", "aab"		 },
+		{ "c(b+b?b|.a)*",	 "dccbba"	 }
+	};
+	size_t i;
+
+	for (i = 0; i < (sizeof(cases) / sizeof(cases[0])); ++i) {
+		TEST_ASSERT_EQUAL_INT(0,
+				      tasty_regex_compile(&regex,
+							  cases[i][0]));
+
+		TEST_ASSERT_EQUAL_INT(0,
+				      tasty_regex_compile_flags(&minimized,
+								cases[i][0],
+								TASTY_COMPILE_MINIMIZE));
+
+		TEST_ASSERT_EQUAL_INT(0,
+				      tasty_regex_run(&regex,
+						      &matches,
+						      cases[i][1]));
+
+		TEST_ASSERT_EQUAL_INT(0,
+				      tasty_regex_run(&minimized,
+						      &minimized_matches,
+						      cases[i][1]));
+
+		TEST_ASSERT_EQUAL_INT(matches.until - matches.from,
+				      minimized_matches.until
+				      - minimized_matches.from);
+		if (matches.until > matches.from)
+			TEST_ASSERT_EQUAL_MEMORY(matches.from,
+						 minimized_matches.from,
+						 sizeof(struct TastyMatch)
+						 * (matches.until
+						    - matches.from));
+
+		tasty_match_interval_free(&minimized_matches);
+		tasty_match_interval_free(&matches);
+		tasty_regex_free(&minimized);
+		tasty_regex_free(&regex);
+	}
+}
+
+void
+test_tasty_regex_run_n(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	/* embedded '\0', length stops short of trailing "gity" */
+	const char data[] = "boo\0boogity";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "b?oo(gity)?"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_n(&regex,
+						&matches,
+						&data[0],
+						7));
+
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(4,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(&data[1], matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(&data[0], matches.from[1].from);
+	TEST_ASSERT_EQUAL_PTR(&data[5], matches.from[2].from);
+	TEST_ASSERT_EQUAL_PTR(&data[4], matches.from[3].from);
+	TEST_ASSERT_EQUAL_PTR(&data[7], matches.from[3].until);
+
+	tasty_match_interval_free(&matches);
+}
+
+void
+test_tasty_regex_run_context(void)
+{
+	struct TastyRegex regex;
+	struct TastyRunContext context;
+	struct TastyMatchInterval matches;
+	struct TastyMatchInterval context_matches;
+	const char *const restrict lines[] = {
+		"boo",
+		"oogity boogity boo, oogity boogity boo",
+		"boogity"
+	};
+	size_t line;
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "b?oo(gity)?"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_run_context_create(&context,
+						       8));
+
+	/* grows past reserved capacity on second line */
+	for (line = 0; line < (sizeof(lines) / sizeof(lines[0])); ++line) {
+		TEST_ASSERT_EQUAL_INT(0,
+				      tasty_regex_run(&regex,
+						      &matches,
+						      lines[line]));
+
+		TEST_ASSERT_EQUAL_INT(0,
+				      tasty_regex_run_context(&regex,
+							      &context,
+							      &context_matches,
+							      lines[line],
+							      strlen(lines[line])));
+
+		TEST_ASSERT_EQUAL_INT(matches.until - matches.from,
+				      context_matches.until
+				      - context_matches.from);
+		TEST_ASSERT_EQUAL_MEMORY(matches.from,
+					 context_matches.from,
+					 sizeof(struct TastyMatch)
+					 * (matches.until - matches.from));
+
+		tasty_match_interval_free(&matches);
+	}
+
+	tasty_run_context_reset(&context);
+	TEST_ASSERT_EQUAL_INT(8,
+			      context.capacity);
+
+	tasty_run_context_destroy(&context);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_stream(void)
+{
+	struct TastyRegex regex;
+	struct TastyStream stream;
+	struct TastyStreamMatchInterval matches;
+	const char *const restrict chunks[] = { "oogi", "ty b", "oogity", " boo" };
+	/* "oogity boogity boo": closed at chunk boundary, mid chunk, at end */
+	const size_t expected[][2] = {
+		{  0,  6 },
+		{  8, 14 },
+		{  7, 14 },
+		{ 16, 18 },
+		{ 15, 18 }
+	};
+	size_t count_matches;
+	size_t chunk;
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "b?oo(gity)?"));
+
+	tasty_stream_begin(&stream,
+			   &regex);
+
+	count_matches = 0;
+
+	for (chunk = 0; chunk < (sizeof(chunks) / sizeof(chunks[0])); ++chunk) {
+		TEST_ASSERT_EQUAL_INT(0,
+				      tasty_stream_feed(&stream,
+							chunks[chunk],
+							strlen(chunks[chunk]),
+							&matches));
+
+		for (; matches.from < matches.until; ++matches.from) {
+			TEST_ASSERT_EQUAL_INT(expected[count_matches][0],
+					      matches.from->from);
+			TEST_ASSERT_EQUAL_INT(expected[count_matches][1],
+					      matches.from->until);
+			++count_matches;
+		}
+	}
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_stream_end(&stream,
+					       &matches));
+
+	struct TastyStreamMatchInterval final_matches = matches;
+
+	for (; matches.from < matches.until; ++matches.from) {
+		TEST_ASSERT_EQUAL_INT(expected[count_matches][0],
+				      matches.from->from);
+		TEST_ASSERT_EQUAL_INT(expected[count_matches][1],
+				      matches.from->until);
+		++count_matches;
+	}
+
+	TEST_ASSERT_EQUAL_INT(5,
+			      count_matches);
+
+	tasty_stream_match_interval_free(&final_matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_run_callback(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	struct MatchCollector collector;
+	const char *const restrict string = "oogity boogity boo";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "b?oo(gity)?"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+
+	collector.count_matches = 0;
+	collector.count_stop	= 0; /* never stop */
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_callback(&regex,
+						       string,
+						       strlen(string),
+						       &collect_match,
+						       &collector));
+
+	TEST_ASSERT_EQUAL_INT(matches.until - matches.from,
+			      collector.count_matches);
+	TEST_ASSERT_EQUAL_MEMORY(matches.from,
+				 &collector.matches[0],
+				 sizeof(struct TastyMatch)
+				 * collector.count_matches);
+
+	/* stop early, callback status is returned */
+	collector.count_matches = 0;
+	collector.count_stop	= 2;
+
+	TEST_ASSERT_EQUAL_INT(42,
+			      tasty_regex_run_callback(&regex,
+						       string,
+						       strlen(string),
+						       &collect_match,
+						       &collector));
+
+	TEST_ASSERT_EQUAL_INT(2,
+			      collector.count_matches);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_test_count(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	bool is_match;
+	size_t count_matches;
+	const char *const restrict string = "oogity boogity boo";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "b?oo(gity)?"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+
+	TEST_ASSERT_EQUAL_INT(matches.until - matches.from,
+			      count_matches);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_test(&regex,
+					       string,
+					       strlen(string),
+					       &is_match));
+	TEST_ASSERT_TRUE(is_match);
+
+	/* match closed only by end of input */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_test(&regex,
+					       "xxboo",
+					       5,
+					       &is_match));
+	TEST_ASSERT_TRUE(is_match);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_test(&regex,
+					       "bo gity o",
+					       9,
+					       &is_match));
+	TEST_ASSERT_FALSE(is_match);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						"bo gity o",
+						9,
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(0,
+			      count_matches);
+
+	/* empty input */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_test(&regex,
+					       "",
+					       0,
+					       &is_match));
+	TEST_ASSERT_FALSE(is_match);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_prefix(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string = "ab abdd xx abc zz ab";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "ERROR: .*timeout"));
+	TEST_ASSERT_EQUAL_INT(7,
+			      regex.length_prefix);
+	TEST_ASSERT_EQUAL_MEMORY("ERROR: ",
+				 &regex.prefix[0],
+				 7);
+	tasty_regex_free(&regex);
+
+	/* optional bytes end prefix */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "ab?c"));
+	TEST_ASSERT_EQUAL_INT(1,
+			      regex.length_prefix);
+	tasty_regex_free(&regex);
+
+	/* wildcard first: no prefix */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  ".abc"));
+	TEST_ASSERT_EQUAL_INT(0,
+			      regex.length_prefix);
+	tasty_regex_free(&regex);
+
+	/* prefix ends at fork, matches found by skipping ahead */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "ab(c|dd)"));
+	TEST_ASSERT_EQUAL_INT(2,
+			      regex.length_prefix);
+	TEST_ASSERT_EQUAL_MEMORY("ab",
+				 &regex.prefix[0],
+				 2);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+	TEST_ASSERT_EQUAL_INT(2,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 3,
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(string + 11,
+			      matches.from[1].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_inner_literal(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string
+	= "GET /api/v2/users GET /api/v11/users POST /api/v1/users";
+
+	/* literal after alternation, 3 or 4 bytes into each match */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "(GET|POST) /api/v1+/users"));
+	TEST_ASSERT_EQUAL_INT(0,
+			      regex.length_prefix);
+	TEST_ASSERT_EQUAL_INT(8,
+			      regex.length_inner);
+	TEST_ASSERT_EQUAL_MEMORY(" /api/v1",
+				 &regex.inner[0],
+				 8);
+	TEST_ASSERT_EQUAL_INT(3,
+			      regex.inner_lead_min);
+	TEST_ASSERT_EQUAL_INT(4,
+			      regex.inner_lead_max);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+	TEST_ASSERT_EQUAL_INT(2,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 18,
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(string + 37,
+			      matches.from[1].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* literal after a loop lies any distance into a match */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "(ab)*cde"));
+	TEST_ASSERT_EQUAL_INT(2,
+			      regex.length_inner);
+	TEST_ASSERT_EQUAL_INT(TASTY_LEAD_UNBOUNDED,
+			      regex.inner_lead_max);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      "xxababcde cd cde"));
+	/* "ababcde", "abcde", "cde", "cde" */
+	TEST_ASSERT_EQUAL_INT(4,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_INT(7,
+			      matches.from[2].until - matches.from[2].from);
+	TEST_ASSERT_EQUAL_INT(3,
+			      matches.from[3].until - matches.from[3].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+static bool
+in_start_set(const struct TastyRegex *const restrict regex,
+	     const unsigned char token)
+{
+	return (regex->start_low[token & 0x0fu] & regex->start_high[token >> 4])
+	    != 0u;
+}
+
+void
+test_tasty_regex_start_set(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	char string[100];
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "(Qx|Zy)+"));
+	TEST_ASSERT_TRUE(regex.has_start_set);
+	TEST_ASSERT_TRUE(in_start_set(&regex, 'Q'));
+	TEST_ASSERT_TRUE(in_start_set(&regex, 'Z'));
+	TEST_ASSERT_FALSE(in_start_set(&regex, 'x'));
+	TEST_ASSERT_FALSE(in_start_set(&regex, '\0'));
+
+	/* candidates past a full vector and in the scalar tail */
+	(void) memset(&string[0],
+		      '-',
+		      sizeof(string) - 1l);
+	string[sizeof(string) - 1l] = '\0';
+	(void) memcpy(&string[40], "QxZy", 4);
+	(void) memcpy(&string[95], "Zy", 2);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      &string[0]));
+	TEST_ASSERT_EQUAL_INT(3,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(&string[42],
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(&string[40],
+			      matches.from[1].from);
+	TEST_ASSERT_EQUAL_PTR(&string[95],
+			      matches.from[2].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* wildcard may begin a match, nothing to filter */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  ".Qx"));
+	TEST_ASSERT_FALSE(regex.has_start_set);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_row_set(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	char pattern[80];
+	const char *const restrict string = "aaab aa";
+	const size_t expected[5][2] = {
+		{ 2, 3 }, { 1, 3 }, { 0, 3 }, { 6, 7 }, { 5, 7 }
+	};
+	size_t count_matches;
+
+	/* starts sharing a row are stepped as one group */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "a+"));
+	TEST_ASSERT_NOT_NULL(regex.row_steps);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+
+	TEST_ASSERT_EQUAL_INT(5,
+			      matches.until - matches.from);
+
+	for (count_matches = 0; count_matches < 5; ++count_matches) {
+		TEST_ASSERT_EQUAL_PTR(string + expected[count_matches][0],
+				      matches.from[count_matches].from);
+		TEST_ASSERT_EQUAL_PTR(string + expected[count_matches][1],
+				      matches.from[count_matches].until);
+	}
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* too many rows: accumulators step alone */
+	(void) memset(&pattern[0],
+		      'a',
+		      sizeof(pattern) - 1l);
+	pattern[sizeof(pattern) - 1l] = '\0';
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  &pattern[0]));
+	TEST_ASSERT_NULL(regex.row_steps);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						&pattern[0],
+						sizeof(pattern) - 1l,
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(1,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_run_mode(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string = "oogity boogity boo";
+	const size_t expected[3][2] = {
+		{ 0, 6 }, { 7, 14 }, { 15, 18 }
+	};
+	size_t i;
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "b?oo(gity)?"));
+
+	/* all matches, as tasty_regex_run_n */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_ALL));
+
+	TEST_ASSERT_EQUAL_INT(5,
+			      matches.until - matches.from);
+
+	tasty_match_interval_free(&matches);
+
+	/* leftmost-longest, non-overlapping */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(3,
+			      matches.until - matches.from);
+
+	for (i = 0; i < 3; ++i) {
+		TEST_ASSERT_EQUAL_PTR(string + expected[i][0],
+				      matches.from[i].from);
+		TEST_ASSERT_EQUAL_PTR(string + expected[i][1],
+				      matches.from[i].until);
+	}
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* the next match starts at the end of the last */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "aa"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   "aaaaa",
+						   5l,
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(2,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_INT(2,
+			      matches.from[1].from - matches.from[0].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* each start keeps its greedy match, not POSIX's longest */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "a|ab"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   "ab",
+						   2l,
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.from[0].until - matches.from[0].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_run_mode_earliest(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string = "baaaa xbaa";
+	const size_t expected[2][2] = {
+		{ 0, 2 }, { 7, 9 }
+	};
+	size_t i;
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "ba+"));
+
+	/* stop at first accept, don't extend */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_EARLIEST));
+
+	TEST_ASSERT_EQUAL_INT(2,
+			      matches.until - matches.from);
+
+	for (i = 0; i < 2; ++i) {
+		TEST_ASSERT_EQUAL_PTR(string + expected[i][0],
+				      matches.from[i].from);
+		TEST_ASSERT_EQUAL_PTR(string + expected[i][1],
+				      matches.from[i].until);
+	}
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_row_set_starts(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string = "ababc abc c";
+	const size_t expected[6][2] = {
+		{ 4, 5 }, { 2, 5 }, { 0, 5 }, { 8, 9 }, { 6, 9 }, { 10, 11 }
+	};
+	size_t i;
+
+	/* starts recovered walking back from where matches close */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "(ab)*c"));
+	TEST_ASSERT_NOT_NULL(regex.row_preds);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+
+	TEST_ASSERT_EQUAL_INT(6,
+			      matches.until - matches.from);
+
+	for (i = 0; i < 6; ++i) {
+		TEST_ASSERT_EQUAL_PTR(string + expected[i][0],
+				      matches.from[i].from);
+		TEST_ASSERT_EQUAL_PTR(string + expected[i][1],
+				      matches.from[i].until);
+	}
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_anchors(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string = "GET a\nGET b GET";
+	size_t count_matches;
+
+	/* start of input only */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "^GET"));
+	TEST_ASSERT_EQUAL_UINT(TASTY_ANCHOR_START,
+			       regex.anchors);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string,
+			      matches.from[0].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* start of any line */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"^GET",
+							TASTY_COMPILE_MULTILINE));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(2,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+
+	/* end of input only, or end of any line */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "GET .$"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(0,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"GET .$",
+							TASTY_COMPILE_MULTILINE));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      string));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 5,
+			      matches.from[0].until);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* '^' and '$' elsewhere match themselves */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "a^b$c"));
+	TEST_ASSERT_EQUAL_UINT(0u,
+			       regex.anchors);
+
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_EMPTY_EXPRESSION,
+			      tasty_regex_compile(&regex,
+						  "^$"));
+}
+
+void
+test_tasty_regex_brackets(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string = "id_7=ok ID=no -]x";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "[a-z_][a-z0-9_]*=[^ ]+"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string,
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(string + 7,
+			      matches.from[0].until);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* leading ']', trailing '-' and escapes are members */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "[]\\-]+x"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 14,
+			      matches.from[0].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_INVALID_BRACKET,
+			      tasty_regex_compile(&regex,
+						  "[a-z"));
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_INVALID_BRACKET,
+			      tasty_regex_compile(&regex,
+						  "[z-a]"));
+}
+
+void
+test_tasty_regex_ignore_case(void)
+{
+	struct TastyRegex regex;
+	size_t count_matches;
+	const char *const restrict string = "Error: ÉTÉ été Été ERROR: CAFÉ рРр";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"error[:]",
+							TASTY_COMPILE_IGNORE_CASE));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(2,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+
+	/* two-byte letters, sharing or differing in lead byte */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							" été",
+							TASTY_COMPILE_IGNORE_CASE));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(3,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"Р+",
+							TASTY_COMPILE_IGNORE_CASE
+							| TASTY_COMPILE_MINIMIZE));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(3,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+
+	/* case still matters without flag */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "error[:]"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(0,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+}
+
+void
+test_tasty_regex_repetition(void)
+{
+	struct TastyRegex regex;
+	struct TastyMatchInterval matches;
+	const char *const restrict string
+	= "sha=0123456789abcdef0123456789abcdef ab abab";
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "=[0-9a-f]{32} "));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 3,
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(string + 37,
+			      matches.from[0].until);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* one short of the bound fails */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "=[0-9a-f]{33}"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      matches.until - matches.from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* group with unbounded upper limit */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "(ab){2,}"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 40,
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(string + 44,
+			      matches.from[0].until);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* '{' not opening an interval is a literal */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile(&regex,
+						  "a{x}"));
+
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_INVALID_REPETITION,
+			      tasty_regex_compile(&regex,
+						  "a{2,1}"));
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_INVALID_REPETITION,
+			      tasty_regex_compile(&regex,
+						  "a{1001}"));
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_NO_OPERAND,
+			      tasty_regex_compile(&regex,
+						  "{2}"));
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_STATE_BUDGET,
+			      tasty_regex_compile(&regex,
+						  "((.{0,1000}){1000}){1000}"));
+}
+
+void
+test_tasty_regex_utf8(void)
+{
+	struct TastyRegex regex;
+	size_t count_matches;
+	struct TastyMatchInterval matches;
+	const char *const restrict string = "id=αβγ;π=3,14;日本=語\xff;";
+
+	/* '.' steps over whole characters, never invalid bytes */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"=...;",
+							TASTY_COMPILE_UTF8));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 2,
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(string + 10,
+			      matches.from[0].until);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"=.;",
+							TASTY_COMPILE_UTF8));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_count(&regex,
+						string,
+						strlen(string),
+						&count_matches));
+	TEST_ASSERT_EQUAL_INT(0,
+			      count_matches);
+
+	tasty_regex_free(&regex);
+
+	/* multibyte ranges, negated brackets */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"[α-ω]+",
+							TASTY_COMPILE_UTF8
+							| TASTY_COMPILE_MINIMIZE));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(2,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 3,
+			      matches.from[0].from);
+	TEST_ASSERT_EQUAL_PTR(string + 9,
+			      matches.from[0].until);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"[^;=]+=[^;]+",
+							TASTY_COMPILE_UTF8));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run_mode(&regex,
+						   &matches,
+						   string,
+						   strlen(string),
+						   TASTY_MATCH_LEFTMOST_LONGEST));
+
+	TEST_ASSERT_EQUAL_INT(3,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_PTR(string + 18,
+			      matches.from[2].from);
+	TEST_ASSERT_EQUAL_PTR(string + 28,
+			      matches.from[2].until);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* a loop commits on the lead byte 'é' shares with included characters,
+	 * so "€" is lost (as "abc" is for "a(bc)*" in "abcbx"), while a
+	 * single '[^é]' closes before stepping on it */
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"[^é]*",
+							TASTY_COMPILE_UTF8));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      "€é"));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      matches.until - matches.from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_compile_flags(&regex,
+							"[^é]",
+							TASTY_COMPILE_UTF8));
+
+	TEST_ASSERT_EQUAL_INT(0,
+			      tasty_regex_run(&regex,
+					      &matches,
+					      "€é"));
+
+	TEST_ASSERT_EQUAL_INT(1,
+			      matches.until - matches.from);
+	TEST_ASSERT_EQUAL_INT(3,
+			      matches.from[0].until - matches.from[0].from);
+
+	tasty_match_interval_free(&matches);
+	tasty_regex_free(&regex);
+
+	/* multibyte members need TASTY_COMPILE_UTF8 */
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_INVALID_BRACKET,
+			      tasty_regex_compile(&regex,
+						  "[α-ω]"));
+
+	TEST_ASSERT_EQUAL_INT(TASTY_ERROR_INVALID_BRACKET,
+			      tasty_regex_compile_flags(&regex,
+							"[ω-α]",
+							TASTY_COMPILE_UTF8));
+}